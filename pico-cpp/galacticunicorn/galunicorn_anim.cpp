@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
+#include <optional>
 #include "pico/stdlib.h"
 #include "pico/time.h"
 #include "pico/platform.h"
@@ -13,6 +14,7 @@
 #include "crawler.h" //This is one of the animation classes used to generate output for the display
 #include "golife.h"  //This is one of the animation classes used to generate output for the display
 #include "gravityparticles.h"  //Another animation class used to generate output for the display
+#include "frame_pacer.hpp" //Paces the animation steps to the loop delay
 
 /*
   Example project for RGB matrix animations library.
@@ -50,7 +52,7 @@ class Animation : public RGBMatrixRenderer {
             uint16_t shake, uint8_t bounce_)
             : RGBMatrixRenderer{graphics.bounds.w,graphics.bounds.h}, 
               animCrawler(*this, steps_, minSteps_,false), 
-              animGol(*this, golFadeSteps_, golDelay_, golStartPattern_),
+              animGol(std::in_place, *this, golFadeSteps_, golDelay_, golStartPattern_),
               animParticles(*this,shake,bounce_)
         {
             //Clear screen
@@ -75,7 +77,7 @@ class Animation : public RGBMatrixRenderer {
         void animationStep() {
             switch (animationMode) {
                 case 0:
-                    animGol.runCycle();
+                    animGol->runCycle();
                    break;
                 case 1:
                     animCrawler.runCycle();
@@ -118,6 +120,14 @@ class Animation : public RGBMatrixRenderer {
             return a + rand()%(b-a);
         }
 
+        //Restart the Game of Life with new settings, keeping the other animations
+        void reconfigure(uint8_t golFadeSteps_, uint16_t golDelay_, uint8_t golStartPattern_) {
+            animGol.emplace(*this, golFadeSteps_, golDelay_, golStartPattern_);
+            graphics.set_pen(graphics.create_pen(0, 0, 0));
+            graphics.clear();
+            setMode(0);
+        }
+
         void setMode(uint8_t mode) {
             cycles = 0;
             animationMode = mode;
@@ -159,44 +169,35 @@ class Animation : public RGBMatrixRenderer {
         }
 
         void drawLine(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2 ){
-            //Get smaller and larger points
-            uint16_t xa = x1;
-            uint16_t xb = x2;
-            uint16_t ya = y1;
-            uint16_t yb = y2;
-            if (x2 < x1) {
-                xa = x2;
-                xb = x1;
-                ya = y2;
-                yb = y1;
-            }
-
             RGB_colour yellow = {255,200,120};
             RGB_colour red = {255,0,0};
             RGB_colour blue = {0,0,255};
 
-            if (xb-xa == 0){
-                if (y2 > y1) {
-                    ya = y1;
-                    yb = y2;
+            //Bresenham line, so steep lines have a cell on every row
+            int x = x1;
+            int y = y1;
+            int dx = abs(x2-x1);
+            int dy = -abs(y2-y1);
+            int sx = x1 < x2 ? 1 : -1;
+            int sy = y1 < y2 ? 1 : -1;
+            int err = dx+dy;
+            while(true){
+                setPixelColour(x,y,yellow);
+                if (x == x2 && y == y2) break;
+                int e2 = 2*err;
+                if (e2 >= dy) {
+                    err += dy;
+                    x += sx;
                 }
-                else {
-                    ya = y2;
-                    yb = y1;
-                }
-                for(uint16_t y=ya; y<=yb; y++){
-                    setPixelColour(xa,y,yellow);
+                if (e2 <= dx) {
+                    err += dx;
+                    y += sy;
                 }
             }
-            else {
-                for(uint16_t x=xa; x<=xb; x++){
-                    uint16_t y = ya + (yb-ya) * (x-xa)/(xb-xa);
-                    setPixelColour(x,y,yellow);
-                }
-                //Mark ends
-                setPixelColour(x1,y1,red);
-                setPixelColour(x2,y2,blue);
-            }
+
+            //Mark ends
+            setPixelColour(x1,y1,red);
+            setPixelColour(x2,y2,blue);
 
             updateDisplay();
         }
@@ -208,7 +209,7 @@ class Animation : public RGBMatrixRenderer {
 
     private:
         Crawler animCrawler;
-        GameOfLife animGol;
+        std::optional<GameOfLife> animGol;
         GravityParticles animParticles;
         uint8_t animationMode;
         Pen WHITE = graphics.create_pen(255, 255, 255);
@@ -251,7 +252,7 @@ int main() {
     uint8_t oldGolStartPattern;
 
     uint16_t loopDelay = 20;
-    uint32_t loopstartTime = time();
+    FramePacer pacer(loopDelay * 1000);
 
     bool crawlerAnyAngle = false;
 
@@ -278,6 +279,7 @@ int main() {
             else {
                 loopDelay -= 10;
                 if (loopDelay > 65000) loopDelay = 0;
+                pacer.setPeriod(loopDelay * 1000);
             }
             sleep_ms(50);
         }
@@ -290,6 +292,7 @@ int main() {
             else {
                 loopDelay += 10;
                 if (loopDelay > 1000) loopDelay = 1000;
+                pacer.setPeriod(loopDelay * 1000);
             }
             sleep_ms(50);
         }
@@ -348,22 +351,21 @@ int main() {
            }
         } 
 
-        if (time() - loopstartTime > loopDelay) {
-            //Loop delay has elasped, so reset loop start time
-            loopstartTime = time();
+        if (pacer.frameDue()) {
+            //Loop delay has elapsed since the last animation step
 
             //Update parameters if changed
             if (golFadeSteps != oldFadeSteps || golStartPattern != oldGolStartPattern){
-                //Need to destroy and recreate animation objects
-                animation.~Animation();
-                new(&animation) Animation(steps,minSteps,golFadeSteps,golDelay,golStartPattern,shake,bounce);
+                //Restart the Game of Life with the new settings
+                animation.reconfigure(golFadeSteps,golDelay,golStartPattern);
             }
 
             //Increment animation cycle
             animation.animationStep();
         }
 
-        sleep_ms(1);
+        //Sleep until the next step is due, waking to check the buttons
+        pacer.sleepUntilFrame(10000);
     }
 
     return 0;
@@ -76,12 +76,22 @@ int16_t LSM6DS3::twosComp(int16_t val) {
   return val;
 }
 
+bool LSM6DS3::isConnected() {
+  uint8_t id;
+  if (i2c_bus->read_bytes(address, WHO_AM_I, &id, 1) != 1) return false;
+  return id == ID_LSM6DS3 || id == ID_LSM6DS3TR_C;
+}
+
 LSM6DS3::SensorData LSM6DS3::getReadings() {
-  uint8_t data[12];  // Buffer to store the raw sensor data
-  i2c_bus->read_bytes(address, OUTX_L_G, data,
-                      12);  // Read 12 bytes starting from OUTX_L_G
+  SensorData readings = {};
+  getReadings(readings);
+  return readings;
+}
 
-  SensorData readings;
+bool LSM6DS3::getReadings(SensorData &readings) {
+  uint8_t data[12];  // Buffer to store the raw sensor data
+  // Read 12 bytes starting from OUTX_L_G
+  if (i2c_bus->read_bytes(address, OUTX_L_G, data, 12) != 12) return false;
 
   // Convert raw data to signed integers
   readings.gx = (data[1] << 8) | data[0];
@@ -102,7 +112,7 @@ LSM6DS3::SensorData LSM6DS3::getReadings() {
   readings.az = (data[11] << 8) | data[10];
   readings.az = twosComp(readings.az);
 
-  return readings;
+  return true;
 }
 
 bool LSM6DS3::singleTapDetected() {
@@ -33,6 +33,9 @@ class LSM6DS3 {
  private:
   // Registers
   static constexpr uint8_t WHO_AM_I = 0x0F;
+  // WHO_AM_I values of the LSM6DS3 and LSM6DS3TR-C
+  static constexpr uint8_t ID_LSM6DS3 = 0x69;
+  static constexpr uint8_t ID_LSM6DS3TR_C = 0x6A;
   static constexpr uint8_t DEFAULT_ADDRESS = 0x6A;
   static constexpr uint8_t CTRL2_G = 0x11;
   static constexpr uint8_t CTRL1_XL = 0x10;
@@ -84,6 +87,11 @@ class LSM6DS3 {
     int16_t gx, gy, gz;  // Gyroscope data
   };
 
+  // Whether the sensor answers on the bus with its WHO_AM_I value
+  bool isConnected();
+
   SensorData getReadings();
+  // Returns false, leaving readings unchanged, if the I2C read fails
+  bool getReadings(SensorData &readings);
   bool singleTapDetected();
 };
@@ -0,0 +1,252 @@
+/*
+ * Renders full resolution frames for the Pimoroni Presto without needing a
+ * full size drawing buffer. Drawing commands for a frame are recorded into a
+ * display list. The list is then replayed into a small buffer holding a band
+ * of rows at a time, and each finished band is copied into the scan-out
+ * buffer by DMA while the next band is drawn. Only finished pixels are ever
+ * written to the screen, using two 480 x 16 bands instead of a second 480 x
+ * 480 buffer.
+ *
+ * Each band is only copied once the display has read its rows, following the
+ * scan-out down the screen from the top of a frame. When a whole frame is
+ * drawn within one refresh of the display, every refresh shows a complete
+ * frame without tearing. A frame which takes longer falls behind the
+ * scan-out, and the refresh it is overtaken in shows part of the old frame.
+ *
+ * Coordinates are in 480 x 480 screen space, as for the Footleg Graphics
+ * library which is used to draw the circles and lines.
+ *
+ * Copyright (c) 2025 Dr Footleg
+ *
+ * License: GNU GPL v3.0
+ */
+#include "band_renderer.hpp"
+
+#include <math.h>
+#include <string.h>
+
+#include "hardware/dma.h"
+#include "pico/time.h"
+
+static const uint16_t screen_height = 480;
+
+BandRenderer::BandRenderer(PicoGraphics_PenRGB565* display,
+                           FootlegGraphics* footlegGraphics,
+                           uint16_t* screen_buffer, uint16_t* band_buffer,
+                           uint16_t band_height)
+    : display(display),
+      footlegGraphics(footlegGraphics),
+      screen_buffer(screen_buffer),
+      band_buffer(band_buffer),
+      band_height(band_height),
+      scanBeam(screen_buffer, display->bounds.w, display->bounds.h) {
+  dmaChannel = dma_claim_unused_channel(true);
+};
+
+void BandRenderer::begin(uint16_t bgPen) {
+  this->bgPen = bgPen;
+  commands.clear();
+  textPool.clear();
+}
+
+void BandRenderer::add(Command& cmd, float y1, float y2) {
+  // Convert the screen rows to display rows, with a pixel spare for AA edges
+  float scale = float(display->bounds.h) / screen_height;
+  int row1 = int(floorf(y1 * scale)) - 1;
+  int row2 = int(ceilf(y2 * scale)) + 2;
+  if (row1 < 0) row1 = 0;
+  if (row2 > display->bounds.h) row2 = display->bounds.h;
+  if (row1 >= row2) return;  // Nothing visible
+  cmd.y1 = row1;
+  cmd.y2 = row2;
+  commands.push_back(cmd);
+}
+
+void BandRenderer::circle(int x, int y, int rad, uint16_t pen) {
+  Command cmd = {CMD_CIRCLE, pen};
+  cmd.circle = {float(x), float(y), float(rad)};
+  add(cmd, y - rad, y + rad);
+}
+
+void BandRenderer::circleAA(float x, float y, float rad, uint16_t pen) {
+  Command cmd = {CMD_CIRCLE_AA, pen};
+  cmd.circle = {x, y, rad};
+  add(cmd, y - rad, y + rad);
+}
+
+void BandRenderer::sphere(int x, int y, int rad, uint16_t pen) {
+  Command cmd = {CMD_SPHERE, pen};
+  cmd.circle = {float(x), float(y), float(rad)};
+  add(cmd, y - rad, y + rad);
+}
+
+void BandRenderer::line(int x1, int y1, int x2, int y2, uint16_t pen) {
+  Command cmd = {CMD_LINE, pen};
+  cmd.line = {float(x1), float(y1), float(x2), float(y2)};
+  add(cmd, y1 < y2 ? y1 : y2, y1 < y2 ? y2 : y1);
+}
+
+void BandRenderer::lineAA(float x1, float y1, float x2, float y2,
+                          uint16_t pen) {
+  Command cmd = {CMD_LINE_AA, pen};
+  cmd.line = {x1, y1, x2, y2};
+  add(cmd, y1 < y2 ? y1 : y2, y1 < y2 ? y2 : y1);
+}
+
+void BandRenderer::rectangle(const Rect& rect, uint16_t pen) {
+  // Rectangles, pixels and text use Pico Graphics, so are in display
+  // coordinates. Convert the rows back to screen rows for add().
+  float scale = float(screen_height) / display->bounds.h;
+  Command cmd = {CMD_RECTANGLE, pen};
+  cmd.rect = {int16_t(rect.x), int16_t(rect.y), int16_t(rect.w),
+              int16_t(rect.h)};
+  add(cmd, rect.y * scale, (rect.y + rect.h) * scale);
+}
+
+void BandRenderer::pixel(const Point& p, uint16_t pen) {
+  float scale = float(screen_height) / display->bounds.h;
+  Command cmd = {CMD_PIXEL, pen};
+  cmd.rect = {int16_t(p.x), int16_t(p.y), 1, 1};
+  add(cmd, p.y * scale, p.y * scale);
+}
+
+void BandRenderer::text(const char* msg, const Point& p, int wrap, int scale,
+                        uint16_t pen) {
+  // Text can wrap, so could reach the bottom of the display
+  Command cmd = {CMD_TEXT, pen};
+  cmd.text = {int16_t(p.x), int16_t(p.y), int16_t(wrap), uint8_t(scale),
+              uint32_t(textPool.size())};
+  textPool.insert(textPool.end(), msg, msg + strlen(msg) + 1);
+  add(cmd, p.y * float(screen_height) / display->bounds.h, screen_height);
+}
+
+void BandRenderer::callback(int y1, int y2, void (*draw)(void* context),
+                            void* context) {
+  Command cmd = {CMD_CALLBACK, 0};
+  cmd.callback = {draw, context};
+  add(cmd, y1, y2);
+}
+
+void BandRenderer::render() {
+  int width = display->bounds.w;
+  int height = display->bounds.h;
+  void* frame_buffer = display->frame_buffer;
+
+  int band = 0;
+  for (int y = 0; y < height; y += band_height) {
+    int rows = height - y < band_height ? height - y : band_height;
+    uint16_t* buffer = band_buffer + band * band_height * width;
+
+    // Point the display at the band buffer, offset so that drawing at row y
+    // lands in its first row. Clipping keeps all drawing inside the band.
+    fillBand(buffer, rows * width);
+    display->frame_buffer = buffer - y * width;
+    display->set_clip(Rect(0, y, width, rows));
+    for (auto& cmd : commands) {
+      if (cmd.y1 < y + rows && cmd.y2 > y) replay(cmd);
+    }
+
+    waitForScan(y, rows);
+    copyBand(buffer, y, rows);
+    band = 1 - band;
+  }
+  dma_channel_wait_for_finish_blocking(dmaChannel);
+
+  display->frame_buffer = frame_buffer;
+  display->remove_clip();
+}
+
+void BandRenderer::replay(const Command& cmd) {
+  switch (cmd.type) {
+    case CMD_CIRCLE:
+      footlegGraphics->drawCircle(cmd.circle.x, cmd.circle.y, cmd.circle.r,
+                                  cmd.pen);
+      break;
+    case CMD_CIRCLE_AA:
+      footlegGraphics->drawCircleAA(cmd.circle.x, cmd.circle.y, cmd.circle.r,
+                                    cmd.pen);
+      break;
+    case CMD_SPHERE:
+      footlegGraphics->drawShadedSphere(cmd.circle.x, cmd.circle.y,
+                                        cmd.circle.r, cmd.pen);
+      break;
+    case CMD_LINE:
+      footlegGraphics->drawLine(cmd.line.x1, cmd.line.y1, cmd.line.x2,
+                                cmd.line.y2, cmd.pen);
+      break;
+    case CMD_LINE_AA:
+      footlegGraphics->drawLineAA(cmd.line.x1, cmd.line.y1, cmd.line.x2,
+                                  cmd.line.y2, cmd.pen);
+      break;
+    case CMD_RECTANGLE:
+      display->set_pen(cmd.pen);
+      display->rectangle(Rect(cmd.rect.x, cmd.rect.y, cmd.rect.w, cmd.rect.h));
+      break;
+    case CMD_PIXEL:
+      display->set_pen(cmd.pen);
+      display->set_pixel(Point(cmd.rect.x, cmd.rect.y));
+      break;
+    case CMD_TEXT:
+      display->set_pen(cmd.pen);
+      display->text(&textPool[cmd.text.offset],
+                    Point(cmd.text.x, cmd.text.y), cmd.text.wrap,
+                    cmd.text.scale);
+      break;
+    case CMD_CALLBACK:
+      cmd.callback.draw(cmd.callback.context);
+      break;
+  }
+}
+
+void BandRenderer::fillBand(uint16_t* band, int pixels) {
+  // Fill two pixels at a time when the band is word aligned
+  if ((uintptr_t)band % 4 == 0) {
+    uint32_t fill = bgPen | (uint32_t)bgPen << 16;
+    uint32_t* words = (uint32_t*)band;
+    for (int i = 0; i < pixels / 2; i++) {
+      words[i] = fill;
+    }
+    if (pixels % 2) band[pixels - 1] = bgPen;
+  } else {
+    for (int i = 0; i < pixels; i++) {
+      band[i] = bgPen;
+    }
+  }
+}
+
+void BandRenderer::waitForScan(int y, int rows) {
+  // Nothing to pace against until the display is scanning out the buffer
+  if (scanBeam.row() < 0) return;
+  uint64_t giveUp = time_us_64() + SCAN_WAIT_LIMIT_US;
+  if (y == 0) {
+    // Start the frame at the top of a refresh, so that the display reads
+    // every band of it in the same refresh if drawing keeps up
+    while (scanBeam.passed(rows) && time_us_64() < giveUp) {
+      tight_loop_contents();
+    }
+  }
+  // Only copy the band once the display has read it, so it shows in full on
+  // the next refresh
+  giveUp = time_us_64() + SCAN_WAIT_LIMIT_US;
+  while (!scanBeam.passed(y + rows) && time_us_64() < giveUp) {
+    tight_loop_contents();
+  }
+}
+
+void BandRenderer::copyBand(const uint16_t* band, int y, int rows) {
+  // The previous band must be copied before its buffer is drawn into again,
+  // and the channel is free for this band once it has been
+  dma_channel_wait_for_finish_blocking(dmaChannel);
+
+  uint16_t* dst = screen_buffer + y * display->bounds.w;
+  uint32_t pixels = rows * display->bounds.w;
+  bool words = ((uintptr_t)band % 4 == 0) && ((uintptr_t)dst % 4 == 0) &&
+               (pixels % 2 == 0);
+  dma_channel_config cfg = dma_channel_get_default_config(dmaChannel);
+  channel_config_set_transfer_data_size(&cfg,
+                                        words ? DMA_SIZE_32 : DMA_SIZE_16);
+  channel_config_set_read_increment(&cfg, true);
+  channel_config_set_write_increment(&cfg, true);
+  dma_channel_configure(dmaChannel, &cfg, dst, band,
+                        words ? pixels / 2 : pixels, true);
+}
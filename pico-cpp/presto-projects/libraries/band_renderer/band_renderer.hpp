@@ -0,0 +1,124 @@
+/*
+ * Renders full resolution frames for the Pimoroni Presto without needing a
+ * full size drawing buffer. Drawing commands for a frame are recorded into a
+ * display list. The list is then replayed into a small buffer holding a band
+ * of rows at a time, and each finished band is copied into the scan-out
+ * buffer by DMA while the next band is drawn. Only finished pixels are ever
+ * written to the screen, using two 480 x 16 bands instead of a second 480 x
+ * 480 buffer.
+ *
+ * Each band is only copied once the display has read its rows, following the
+ * scan-out down the screen from the top of a frame. When a whole frame is
+ * drawn within one refresh of the display, every refresh shows a complete
+ * frame without tearing. A frame which takes longer falls behind the
+ * scan-out, and the refresh it is overtaken in shows part of the old frame.
+ *
+ * Coordinates are in 480 x 480 screen space, as for the Footleg Graphics
+ * library which is used to draw the circles and lines.
+ *
+ * Copyright (c) 2025 Dr Footleg
+ *
+ * License: GNU GPL v3.0
+ */
+#pragma once
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "../graphics/footleg_graphics.hpp"
+#include "../scan_beam/scan_beam.hpp"
+#include "libraries/pico_graphics/pico_graphics.hpp"
+
+using namespace pimoroni;
+
+class BandRenderer {
+ public:
+  // The display must be the same size as the scan-out buffer. The band buffer
+  // must hold two bands of band_height rows of the display width.
+  BandRenderer(PicoGraphics_PenRGB565* display,
+               FootlegGraphics* footlegGraphics, uint16_t* screen_buffer,
+               uint16_t* band_buffer, uint16_t band_height);
+
+  // Start a new display list, with the whole frame cleared to a pen colour
+  void begin(uint16_t bgPen);
+
+  // Record drawing commands
+  void circle(int x, int y, int rad, uint16_t pen);
+  void circleAA(float x, float y, float rad, uint16_t pen);
+  void sphere(int x, int y, int rad, uint16_t pen);
+  void line(int x1, int y1, int x2, int y2, uint16_t pen);
+  void lineAA(float x1, float y1, float x2, float y2, uint16_t pen);
+  void rectangle(const Rect& rect, uint16_t pen);
+  void pixel(const Point& p, uint16_t pen);
+  void text(const char* msg, const Point& p, int wrap, int scale,
+            uint16_t pen);
+  // Calls draw(context) for each band overlapping screen rows y1 to y2, for
+  // drawing not covered by the other commands (e.g. Pico Vector shapes).
+  // It must draw using the display, which is clipped to the band.
+  void callback(int y1, int y2, void (*draw)(void* context), void* context);
+
+  // Draw the display list into the scan-out buffer, one band at a time
+  void render();
+
+ private:
+  enum CommandType : uint8_t {
+    CMD_CIRCLE,
+    CMD_CIRCLE_AA,
+    CMD_SPHERE,
+    CMD_LINE,
+    CMD_LINE_AA,
+    CMD_RECTANGLE,
+    CMD_PIXEL,
+    CMD_TEXT,
+    CMD_CALLBACK
+  };
+
+  // One recorded drawing command. Rows y1 to y2 - 1 of the display can be
+  // touched by it, so it is only replayed into bands overlapping them.
+  struct Command {
+    CommandType type;
+    uint16_t pen;
+    int16_t y1, y2;
+    union {
+      struct {
+        float x, y, r;
+      } circle;
+      struct {
+        float x1, y1, x2, y2;
+      } line;
+      struct {
+        int16_t x, y, w, h;
+      } rect;
+      struct {
+        int16_t x, y, wrap;
+        uint8_t scale;
+        uint32_t offset;  // Start of the text in the text pool
+      } text;
+      struct {
+        void (*draw)(void* context);
+        void* context;
+      } callback;
+    };
+  };
+
+  // Time after which a band is copied regardless, in case the scan line is
+  // stuck
+  static const uint32_t SCAN_WAIT_LIMIT_US = 20000;
+
+  PicoGraphics_PenRGB565* display;
+  FootlegGraphics* footlegGraphics;
+  uint16_t* screen_buffer;
+  uint16_t* band_buffer;
+  uint16_t band_height;
+  uint16_t bgPen = 0;
+  int dmaChannel = -1;
+  ScanBeam scanBeam;
+  std::vector<Command> commands;
+  std::vector<char> textPool;  // Text for the text commands
+  void add(Command& cmd, float y1, float y2);
+  void replay(const Command& cmd);
+  void fillBand(uint16_t* band, int pixels);
+  void copyBand(const uint16_t* band, int y, int rows);
+  void waitForScan(int y, int rows);
+};
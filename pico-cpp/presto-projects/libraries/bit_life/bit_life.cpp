@@ -0,0 +1,105 @@
+/*
+ * A bit packed Game of Life engine, counting the neighbours of 32 cells at a
+ * time with bitwise adders.
+ *
+ * Copyright (c) 2025 Dr Footleg
+ *
+ * License: GNU GPL v3.0
+ */
+#include "bit_life.hpp"
+
+#include <stdlib.h>
+
+BitLife::BitLife(uint16_t width, uint16_t height, bool wrap)
+    : width(width), height(height), wrap(wrap) {
+  wordsPerRow = (width + 31) / 32;
+  uint16_t lastBits = width - (wordsPerRow - 1) * 32;
+  lastMask = lastBits == 32 ? 0xFFFFFFFF : (1u << lastBits) - 1;
+  cells.assign(wordsPerRow * height, 0);
+  changed.assign(wordsPerRow * height, 0);
+  above.resize(wordsPerRow);
+  current.resize(wordsPerRow);
+  firstRow.resize(wordsPerRow);
+}
+
+void BitLife::clear() {
+  cells.assign(cells.size(), 0);
+  changed.assign(changed.size(), 0);
+  generation = 0;
+}
+
+void BitLife::randomise(uint8_t density) {
+  for (uint16_t y = 0; y < height; y++) {
+    for (uint16_t x = 0; x < width; x++) {
+      setCell(x, y, (rand() & 0xFF) < density);
+    }
+  }
+  changed.assign(changed.size(), 0);
+  generation = 0;
+}
+
+void BitLife::setCell(uint16_t x, uint16_t y, bool alive) {
+  uint32_t& word = cells[y * wordsPerRow + (x >> 5)];
+  uint32_t bit = 1u << (x & 31);
+  word = alive ? word | bit : word & ~bit;
+}
+
+uint32_t BitLife::population() {
+  uint32_t count = 0;
+  for (uint32_t word : cells) count += __builtin_popcount(word);
+  return count;
+}
+
+uint32_t BitLife::step() {
+  // Rows are overwritten as they are calculated, so keep the old copy of the
+  // row above, and of the first row for the last row to wrap round to
+  uint32_t* rows = cells.data();
+  uint32_t lastRow = (height - 1) * wordsPerRow;
+  for (uint16_t i = 0; i < wordsPerRow; i++) {
+    above[i] = wrap ? rows[lastRow + i] : 0;
+    firstRow[i] = wrap ? rows[i] : 0;
+  }
+
+  uint32_t changes = 0;
+  for (uint16_t y = 0; y < height; y++) {
+    uint32_t* row = &rows[y * wordsPerRow];
+    for (uint16_t i = 0; i < wordsPerRow; i++) current[i] = row[i];
+    const uint32_t* below =
+        y + 1 < height ? row + wordsPerRow : firstRow.data();
+    uint32_t* diff = &changed[y * wordsPerRow];
+    stepRow(above.data(), current.data(), below, row, diff);
+    for (uint16_t i = 0; i < wordsPerRow; i++) {
+      changes += __builtin_popcount(diff[i]);
+    }
+    above.swap(current);
+  }
+  generation++;
+  return changes;
+}
+
+void BitLife::stepRow(const uint32_t* up, const uint32_t* mid,
+                      const uint32_t* down, uint32_t* out, uint32_t* diff) {
+  const uint32_t* rows[3] = {up, mid, down};
+  uint16_t last = wordsPerRow - 1;
+  uint16_t lastBit = (width - 1) & 31;
+  for (uint16_t i = 0; i <= last; i++) {
+    // Each row shifted so that every cell lines up with its neighbours to the
+    // west and east, carrying in the edge cells of the adjoining words
+    uint32_t west[3], row[3], east[3];
+    for (int r = 0; r < 3; r++) {
+      const uint32_t* words = rows[r];
+      uint32_t carryWest = i > 0 ? words[i - 1] >> 31
+                                 : (wrap ? (words[last] >> lastBit) & 1 : 0);
+      uint32_t carryEast = i < last ? words[i + 1] & 1 : 0;
+      row[r] = words[i];
+      west[r] = words[i] << 1 | carryWest;
+      east[r] = words[i] >> 1 | carryEast << 31;
+      if (i == last && wrap) east[r] |= (words[0] & 1) << lastBit;
+    }
+
+    uint32_t next = nextCells(west, row, east);
+    if (i == last) next &= lastMask;
+    diff[i] = next ^ mid[i];
+    out[i] = next;
+  }
+}
@@ -0,0 +1,95 @@
+/*
+ * A bit packed Game of Life engine. Cells are held 32 to a word, and the
+ * neighbours of all 32 cells in a word are counted at once by adding up
+ * shifted copies of the rows above and below with bitwise full adders. Each
+ * generation is calculated in place, keeping just the rows it still needs in
+ * a rolling buffer, along with a plane of the cells which changed so that
+ * only those need to be redrawn.
+ *
+ * Copyright (c) 2025 Dr Footleg
+ *
+ * License: GNU GPL v3.0
+ */
+#pragma once
+
+#include <stdint.h>
+
+#include <vector>
+
+class BitLife {
+ public:
+  // With wrap set, cells on each edge have the cells on the opposite edge as
+  // neighbours. Otherwise cells beyond the edges are always dead.
+  BitLife(uint16_t width, uint16_t height, bool wrap = true);
+
+  uint16_t getWidth() { return width; }
+  uint16_t getHeight() { return height; }
+  uint16_t getWordsPerRow() { return wordsPerRow; }
+
+  void clear();
+  // Set each cell alive with a chance of density out of 256
+  void randomise(uint8_t density);
+  void setCell(uint16_t x, uint16_t y, bool alive);
+  bool getCell(uint16_t x, uint16_t y) {
+    return (cells[y * wordsPerRow + (x >> 5)] >> (x & 31)) & 1;
+  }
+
+  // Calculate the next generation (B3/S23). Returns the number of cells which
+  // were born or died.
+  uint32_t step();
+
+  // Bits set for cells which changed in the last step, 32 cells to a word
+  const uint32_t* changedRow(uint16_t y) {
+    return &changed[y * wordsPerRow];
+  }
+
+  uint32_t getGeneration() { return generation; }
+  uint32_t population();
+
+  // Next state of 32 cells in a word. row holds the words above, containing
+  // and below the cells, and west and east hold the same words shifted to
+  // line the cells up with their neighbours on each side.
+  static uint32_t nextCells(const uint32_t west[3], const uint32_t row[3],
+                            const uint32_t east[3]) {
+    // Add up the eight neighbours of each cell into a 3 bit count. A count of
+    // 8 wraps round to 0, which has the same outcome.
+    uint32_t s0, c0, s1, c1, ones, c3, t0, d0;
+    fullAdd(west[0], row[0], east[0], s0, c0);
+    fullAdd(west[2], row[2], east[2], s1, c1);
+    uint32_t s2 = west[1] ^ east[1];
+    uint32_t c2 = west[1] & east[1];
+    fullAdd(s0, s1, s2, ones, c3);
+    fullAdd(c0, c1, c2, t0, d0);
+    uint32_t twos = t0 ^ c3;
+    uint32_t fours = d0 ^ (t0 & c3);
+
+    // Alive with 3 neighbours, or 2 neighbours if already alive
+    return twos & ~fours & (ones | row[1]);
+  }
+
+ private:
+  uint16_t width;
+  uint16_t height;
+  uint16_t wordsPerRow;
+  bool wrap;
+  uint32_t lastMask;  // Valid cells in the last word of each row
+  uint32_t generation = 0;
+  std::vector<uint32_t> cells;
+  std::vector<uint32_t> changed;
+  // Rolling buffer of the previous generation: the row above the one being
+  // calculated, that row itself, and the first row for wrapping round
+  std::vector<uint32_t> above;
+  std::vector<uint32_t> current;
+  std::vector<uint32_t> firstRow;
+
+  // Adds three 1 bit numbers in each bit position
+  static void fullAdd(uint32_t a, uint32_t b, uint32_t c, uint32_t& sum,
+                      uint32_t& carry) {
+    uint32_t ab = a ^ b;
+    sum = ab ^ c;
+    carry = (a & b) | (ab & c);
+  }
+
+  void stepRow(const uint32_t* up, const uint32_t* mid, const uint32_t* down,
+               uint32_t* out, uint32_t* diff);
+};
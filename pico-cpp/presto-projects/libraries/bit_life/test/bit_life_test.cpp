@@ -0,0 +1,105 @@
+/*
+ * Host check of the bit packed Game of Life against a plain cell by cell
+ * implementation of the same rule (B3/S23), on random grids with and without
+ * wrapping round the edges. Widths which are not a multiple of 32 check the
+ * partly used last word of each row.
+ *
+ * Copyright (c) 2025 Dr Footleg
+ *
+ * License: GNU GPL v3.0
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <vector>
+
+#include "../bit_life.hpp"
+
+static const int GENERATIONS = 200;
+
+// One generation of the rule, a cell at a time
+static void scalarStep(std::vector<bool>& cells, int width, int height,
+                       bool wrap) {
+  std::vector<bool> next(cells.size());
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      int count = 0;
+      for (int dy = -1; dy <= 1; dy++) {
+        for (int dx = -1; dx <= 1; dx++) {
+          if (dx == 0 && dy == 0) continue;
+          int nx = x + dx;
+          int ny = y + dy;
+          if (wrap) {
+            nx = (nx + width) % width;
+            ny = (ny + height) % height;
+          } else if (nx < 0 || ny < 0 || nx >= width || ny >= height) {
+            continue;
+          }
+          count += cells[ny * width + nx];
+        }
+      }
+      bool alive = cells[y * width + x];
+      next[y * width + x] = count == 3 || (alive && count == 2);
+    }
+  }
+  cells.swap(next);
+}
+
+// Run both engines from the same start, returning false at the first
+// generation where they differ
+static bool compare(int width, int height, bool wrap, uint8_t density) {
+  BitLife life(width, height, wrap);
+  life.randomise(density);
+  std::vector<bool> cells(width * height);
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) cells[y * width + x] = life.getCell(x, y);
+  }
+
+  for (int gen = 1; gen <= GENERATIONS; gen++) {
+    std::vector<bool> last = cells;
+    scalarStep(cells, width, height, wrap);
+    uint32_t changes = life.step();
+
+    uint32_t expectedChanges = 0;
+    for (int y = 0; y < height; y++) {
+      const uint32_t* changed = life.changedRow(y);
+      for (int x = 0; x < width; x++) {
+        bool alive = cells[y * width + x];
+        bool flipped = alive != last[y * width + x];
+        expectedChanges += flipped;
+        if (life.getCell(x, y) != alive ||
+            bool((changed[x >> 5] >> (x & 31)) & 1) != flipped) {
+          printf("FAIL %dx%d wrap=%d: cell %d,%d differs in generation %d\n",
+                 width, height, wrap, x, y, gen);
+          return false;
+        }
+      }
+    }
+    if (changes != expectedChanges) {
+      printf("FAIL %dx%d wrap=%d: %u changes in generation %d, expected %u\n",
+             width, height, wrap, changes, gen, expectedChanges);
+      return false;
+    }
+  }
+  printf("ok   %dx%d wrap=%d\n", width, height, wrap);
+  return true;
+}
+
+int main() {
+  srand(1);
+  // Sizes used on the Presto, and awkward ones: a single word, a single
+  // part word, widths either side of a word boundary and tiny grids where
+  // wrapping makes a cell its own neighbour more than once.
+  const int sizes[][2] = {{240, 240}, {160, 160}, {32, 32}, {31, 17},
+                          {33, 5},    {64, 64},   {97, 40}, {3, 3},
+                          {1, 8},     {5, 1}};
+  bool passed = true;
+  for (auto& size : sizes) {
+    for (bool wrap : {true, false}) {
+      passed &= compare(size[0], size[1], wrap, 96);
+    }
+  }
+  // A dense grid, to reach every neighbour count
+  passed &= compare(64, 48, true, 200);
+  return passed ? 0 : 1;
+}
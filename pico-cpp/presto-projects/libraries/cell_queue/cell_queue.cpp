@@ -0,0 +1,35 @@
+/*
+ * A lock free queue of cell changes passed between the two cores.
+ *
+ * Copyright (c) 2025 Dr Footleg
+ *
+ * License: GNU GPL v3.0
+ */
+#include "cell_queue.hpp"
+
+#include "hardware/sync.h"
+#include "pico/platform.h"
+
+CellQueue::CellQueue(Cell* storage, uint32_t capacity)
+    : cells(storage), mask(capacity - 1) {};
+
+void CellQueue::push(const Cell& cell) {
+  while (head - tail > mask) tight_loop_contents();
+  cells[head & mask] = cell;
+  // The cell must be written before the other core sees the new head
+  __dmb();
+  head = head + 1;
+}
+
+void CellQueue::pushEndOfCycle() { push({0, 0, 0, 0, 0, true}); }
+
+bool CellQueue::pop(Cell& cell) {
+  if (tail == head) return false;
+  // Read the cell only after seeing the head which covers it
+  __dmb();
+  cell = cells[tail & mask];
+  // And finish reading it before the slot is handed back
+  __dmb();
+  tail = tail + 1;
+  return true;
+}
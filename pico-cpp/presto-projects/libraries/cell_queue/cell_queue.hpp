@@ -0,0 +1,42 @@
+/*
+ * A lock free queue of cell changes, passed from an animation running on one
+ * core to the renderer drawing them on the other. Only one core may push and
+ * only the other may pop. Each side only writes its own index into the ring,
+ * so no locks are needed, just memory barriers to make sure a cell is in the
+ * ring before the other core can see it there.
+ *
+ * Copyright (c) 2025 Dr Footleg
+ *
+ * License: GNU GPL v3.0
+ */
+#pragma once
+
+#include <stdint.h>
+
+class CellQueue {
+ public:
+  struct Cell {
+    uint16_t x;
+    uint16_t y;
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+    bool endOfCycle;  // Marks the end of the cells for an animation cycle
+  };
+
+  // The capacity must be a power of 2
+  CellQueue(Cell* storage, uint32_t capacity);
+
+  // Add a cell, waiting for the other core to make space if the queue is full
+  void push(const Cell& cell);
+  void pushEndOfCycle();
+
+  // Take the oldest cell. Returns false if the queue is empty.
+  bool pop(Cell& cell);
+
+ private:
+  Cell* cells;
+  uint32_t mask;
+  volatile uint32_t head = 0;  // Next slot to push into, written by pushes
+  volatile uint32_t tail = 0;  // Next slot to pop from, written by pops
+};
@@ -0,0 +1,86 @@
+/*
+ * Paces a render loop to a target frame period, sleeping until a hardware
+ * alarm for the next frame fires.
+ *
+ * Copyright (c) 2025 Dr Footleg
+ *
+ * License: GNU GPL v3.0
+ */
+#include "frame_pacer.hpp"
+
+#include "pico/stdlib.h"
+#include "pico/sync.h"
+
+FramePacer::FramePacer(uint32_t period_us) : period_us(period_us) {
+  frameStart = get_absolute_time();
+  nextFrame = delayed_by_us(frameStart, period_us);
+};
+
+void FramePacer::setPeriod(uint32_t period_us) {
+  this->period_us = period_us;
+  nextFrame = delayed_by_us(frameStart, period_us);
+}
+
+void FramePacer::setIdleTask(IdleTask task, void* context) {
+  idleTask = task;
+  idleContext = context;
+}
+
+int64_t FramePacer::alarmCallback(alarm_id_t id, void* user_data) {
+  FramePacer* pacer = (FramePacer*)user_data;
+  pacer->due = true;
+  __sev();  // Wake the core if it is waiting for an event
+  return 0;  // Don't repeat
+}
+
+bool FramePacer::waitForFrame() {
+  absolute_time_t now = get_absolute_time();
+  frameUs = absolute_time_diff_us(frameStart, now);
+  bool late = absolute_time_diff_us(now, nextFrame) <= 0;
+
+  if (late) {
+    overrunCount++;
+  } else {
+    due = false;
+    alarm_id_t alarm = add_alarm_at(nextFrame, alarmCallback, this, false);
+    if (alarm < 0) {
+      // No alarm slots free, so fall back on the SDK sleep
+      sleep_until(nextFrame);
+    } else if (alarm > 0) {
+      bool busy = idleTask != nullptr;
+      while (!due) {
+        if (busy) {
+          busy = idleTask(idleContext);
+        } else {
+          __wfe();
+        }
+      }
+    }
+    // An id of 0 means the time passed before the alarm could be set
+  }
+  startNextFrame();
+  return late;
+}
+
+bool FramePacer::frameDue() {
+  absolute_time_t now = get_absolute_time();
+  if (absolute_time_diff_us(now, nextFrame) > 0) return false;
+  startNextFrame();
+  return true;
+}
+
+void FramePacer::sleepUntilFrame(uint32_t max_us) {
+  absolute_time_t wake = make_timeout_time_us(max_us);
+  if (absolute_time_diff_us(nextFrame, wake) > 0) wake = nextFrame;
+  sleep_until(wake);
+}
+
+void FramePacer::startNextFrame() {
+  // Keep to the period on average by timing the next frame from when this one
+  // was due, unless it is so late that frames would bunch up to catch up
+  nextFrame = delayed_by_us(nextFrame, period_us);
+  frameStart = get_absolute_time();
+  if (absolute_time_diff_us(frameStart, nextFrame) <= 0) {
+    nextFrame = delayed_by_us(frameStart, period_us);
+  }
+}
@@ -0,0 +1,55 @@
+/*
+ * Paces a render loop to a target frame period. Call waitForFrame() at the
+ * end of each frame, and it sleeps only for whatever is left of the period,
+ * woken by a hardware alarm. Frames which take longer than the period are
+ * counted as overruns and the next frame starts straight away, rather than
+ * sleeping a fixed time on top of the work done. Spare time before the next
+ * frame can be handed to a background task instead of sleeping.
+ *
+ * Copyright (c) 2025 Dr Footleg
+ *
+ * License: GNU GPL v3.0
+ */
+#pragma once
+
+#include <stdint.h>
+
+#include "pico/time.h"
+
+class FramePacer {
+ public:
+  // A background task run repeatedly while waiting for the next frame. Each
+  // call should do a short piece of work, and return false once there is
+  // nothing left to do until the next frame.
+  typedef bool (*IdleTask)(void* context);
+
+  FramePacer(uint32_t period_us);
+  void setPeriod(uint32_t period_us);
+  void setIdleTask(IdleTask task, void* context);
+
+  // Wait until the next frame is due. Returns true if the frame just finished
+  // overran the period.
+  bool waitForFrame();
+
+  // For loops which poll for input between frames. frameDue() returns true
+  // once the next frame is due (and starts timing the one after it), and
+  // sleepUntilFrame() sleeps until then, or for at most max_us.
+  bool frameDue();
+  void sleepUntilFrame(uint32_t max_us);
+
+  uint32_t overruns() { return overrunCount; }
+  // Time spent on the last frame, not including the wait at the end of it
+  uint32_t lastFrameUs() { return frameUs; }
+
+ private:
+  uint32_t period_us;
+  absolute_time_t nextFrame;
+  absolute_time_t frameStart;
+  uint32_t frameUs = 0;
+  uint32_t overrunCount = 0;
+  volatile bool due = false;
+  IdleTask idleTask = nullptr;
+  void* idleContext = nullptr;
+  static int64_t alarmCallback(alarm_id_t id, void* user_data);
+  void startNextFrame();
+};
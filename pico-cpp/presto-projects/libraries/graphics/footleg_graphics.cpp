@@ -12,13 +12,141 @@
  */
 #include "footleg_graphics.hpp"
 
+#include <string.h>
+
+#include <algorithm>
+
 #include "libraries/pico_graphics/pico_graphics.hpp"
 
 using namespace pimoroni;
 
 FootlegGraphics::FootlegGraphics(PicoGraphics_PenRGB565* display,
                                  uint16_t* screen_buffer)
-    : display(display), screen_buffer(screen_buffer) {};
+    : display(display), screen_buffer(screen_buffer) {
+  // Pico Graphics may store RGB565 pens byte swapped for the display
+  penSwapped = display->create_pen(255, 0, 0) != 0xF800;
+  whitePen = display->create_pen(255, 255, 255);
+  buildCoverageLUT();
+  buildHighlightLUT();
+};
+
+FootlegGraphics::FootlegGraphics(PicoGraphics_PenP8* display,
+                                 uint8_t* screen_buffer)
+    : display(display), screen_buffer(screen_buffer), indexed(true) {
+  // Palette entry 0 is the black background which AA edges blend into
+  penSwapped = false;
+  display->update_pen(0, 0, 0, 0);
+  whitePen = createPen(255, 255, 255);
+  buildCoverageLUT();
+  buildHighlightLUT();
+};
+
+void FootlegGraphics::setLineCache(LineCache* cache) { lineCache = cache; }
+
+uint16_t FootlegGraphics::createPen(uint8_t r, uint8_t g, uint8_t b) {
+  if (!indexed) return display->create_pen(r, g, b);
+
+  // Find a free run of palette entries for a ramp from just above black up
+  // to the colour, and return the entry for the colour itself
+  PicoGraphics_PenP8* p8 = static_cast<PicoGraphics_PenP8*>(display);
+  int run = 0;
+  for (int i = 1; i < PicoGraphics_PenP8::palette_size; ++i) {
+    run = p8->used[i] ? 0 : run + 1;
+    if (run < PALETTE_RAMP_SIZE) continue;
+    int first = i - PALETTE_RAMP_SIZE + 1;
+    for (int level = 1; level <= PALETTE_RAMP_SIZE; ++level) {
+      p8->update_pen(first + level - 1, r * level / PALETTE_RAMP_SIZE,
+                     g * level / PALETTE_RAMP_SIZE,
+                     b * level / PALETTE_RAMP_SIZE);
+      rampLevel[first + level - 1] = level;
+    }
+    return i;
+  }
+  // No room for a ramp, so fall back to a single entry without blending
+  int pen = display->create_pen(r, g, b);
+  return pen < 0 ? 0 : pen;
+}
+
+template <typename T>
+T* FootlegGraphics::rowPointer(int y, int x1, int x2) {
+  // Pixel 0 of row y, where pixels x1 to x2 are about to be read or written
+  if constexpr (sizeof(T) == sizeof(uint16_t)) {
+    if (lineCache) {
+      const Rect& clip = display->clip;
+      if (x1 < clip.x) x1 = clip.x;
+      if (x2 > clip.x + clip.w - 1) x2 = clip.x + clip.w - 1;
+      return lineCache->row(y, x1, x2);
+    }
+  }
+  return (T*)display->frame_buffer + y * display->bounds.w;
+}
+
+bool FootlegGraphics::blankPixel(int x, int y) {
+  if (indexed) return rowPointer<uint8_t>(y, x, x)[x] == 0;
+  return rowPointer<uint16_t>(y, x, x)[x] == 0;
+}
+
+void FootlegGraphics::buildCoverageLUT() {
+  // Area of a square pixel on the inside of a straight edge, averaged over
+  // edge angles from 0 to 45 degrees. The distance t of the edge from the
+  // pixel centre is measured as a fraction of the pixel width across the
+  // edge, so -0.5 just touches the pixel and 0.5 covers it entirely.
+  const int ANGLES = 8;
+  for (int i = 0; i < COVERAGE_LUT_SIZE; ++i) {
+    float t = (i + 0.5f) / COVERAGE_LUT_SIZE - 0.5f;
+    float area = 0;
+    for (int a = 0; a < ANGLES; ++a) {
+      float angle = (a + 0.5f) * float(M_PI) / 4 / ANGLES;
+      float c = std::cos(angle);
+      float s = std::sin(angle);
+      float h = (c + s) / 2;  // Half width of the pixel across the edge
+      float k = (c - s) / 2;  // Half width of the part with linear coverage
+      float d = t * 2 * h;
+      if (d < -k) {
+        area += (d + h) * (d + h) / (2 * c * s);
+      } else if (d <= k) {
+        area += 0.5f + d / c;
+      } else {
+        area += 1 - (h - d) * (h - d) / (2 * c * s);
+      }
+    }
+    coverageLUT[i] = std::round(area * 255 / ANGLES);
+  }
+}
+
+uint16_t FootlegGraphics::blendPen(uint16_t bg, uint16_t fg, uint8_t alpha) {
+  if (indexed) return blendIndex(bg, fg, alpha);
+  return blendRGB565(bg, fg, alpha);
+}
+
+uint16_t FootlegGraphics::blendRGB565(uint16_t bg, uint16_t fg,
+                                      uint8_t alpha) {
+  if (penSwapped) {
+    bg = __builtin_bswap16(bg);
+    fg = __builtin_bswap16(fg);
+  }
+  // Blend all three channels at once, with green moved into the top half
+  // word so each channel has spare bits above it
+  uint32_t a = (alpha + 4) >> 3;
+  uint32_t b32 = (bg | (bg << 16)) & 0x07E0F81F;
+  uint32_t f32 = (fg | (fg << 16)) & 0x07E0F81F;
+  uint32_t result = ((((f32 - b32) * a) >> 5) + b32) & 0x07E0F81F;
+  uint16_t colour = result | (result >> 16);
+  return penSwapped ? __builtin_bswap16(colour) : colour;
+}
+
+uint8_t FootlegGraphics::blendIndex(uint8_t bg, uint8_t fg, uint8_t alpha) {
+  // A pen on a ramp blends towards black, or another shade of the same ramp,
+  // by moving along the ramp. Anything else has no entry between the two
+  // colours, so takes whichever covers most of the pixel.
+  int fgLevel = rampLevel[fg];
+  int bgLevel = rampLevel[bg];
+  if (fgLevel > 0 && (bg == 0 || bg - bgLevel == fg - fgLevel)) {
+    int level = bgLevel + ((fgLevel - bgLevel) * alpha + 127) / 255;
+    return level == 0 ? 0 : fg - fgLevel + level;
+  }
+  return alpha >= 128 ? fg : bg;
+}
 
 void FootlegGraphics::circle_scaled(const Point& p, int32_t radius_x,
                                     int32_t radius_y) {
@@ -45,19 +173,22 @@ void FootlegGraphics::drawAASpan(float x, int y, float width, uint16_t pen) {
     int iX2 = std::floor(x + width * 2);
 
     // Set tick at original start and end
-    RGB rgb = PicoGraphics::rgb565_to_rgb(pen);
+    uint16_t penAA;
+    if (indexed) {
+      penAA = blendIndex(0, pen, spanX * 255);
+    } else {
+      RGB rgb = PicoGraphics::rgb565_to_rgb(pen);
+      penAA = display->create_pen(rgb.r * spanX, rgb.g * spanX, rgb.b * spanX);
+    }
     // Antialias start and end pixels into black only if background is black
-    uint16_t penAA =
-        display->create_pen(rgb.r * spanX, rgb.g * spanX, rgb.b * spanX);
     display->set_pen(penAA);
-    if (y < display->bounds.h) {
-      if (iX1 < display->bounds.w) {
-        if (screen_buffer[y * display->bounds.w + iX1] == 0)
-          display->set_pixel(Point(iX1, y));
+    const Rect& clip = display->clip;
+    if (y >= clip.y && y < clip.y + clip.h) {
+      if (iX1 >= clip.x && iX1 < clip.x + clip.w) {
+        if (blankPixel(iX1, y)) display->set_pixel(Point(iX1, y));
       }
-      if (iX2 < display->bounds.w) {
-        if (screen_buffer[y * display->bounds.w + iX2] == 0)
-          display->set_pixel(Point(iX2, y));
+      if (iX2 >= clip.x && iX2 < clip.x + clip.w) {
+        if (blankPixel(iX2, y)) display->set_pixel(Point(iX2, y));
       }
       // Draw solid span between end pixels
       display->set_pen(pen);
@@ -94,6 +225,173 @@ void FootlegGraphics::drawCircleAA(int centreX, int centreY, int rad,
   }
 }
 
+bool FootlegGraphics::circleRowExtent(float centreX, float dy, float rad,
+                                      float pixW, float pixH,
+                                      RowExtent& ext) {
+  // Vertical distances from the centre to the nearest and furthest edges of
+  // this row of pixels
+  float nearY = std::fabs(dy) - pixH / 2;
+  float farY = std::fabs(dy) + pixH / 2;
+  if (nearY < 0) nearY = 0;
+  if (nearY >= rad) return false;
+
+  // Pixels between the touch limits are touched by the circle. Pixels
+  // between the full limits are entirely inside it.
+  float touch = std::sqrt(rad * rad - nearY * nearY);
+  float full = farY < rad ? std::sqrt(rad * rad - farY * farY) : -1;
+  ext.touchX1 = std::floor((centreX - touch) / pixW);
+  ext.touchX2 = std::floor((centreX + touch) / pixW);
+  ext.fullX1 = std::ceil((centreX - full) / pixW);
+  ext.fullX2 = std::floor((centreX + full) / pixW) - 1;
+  if (full < 0 || ext.fullX1 > ext.fullX2) {
+    // No pixels entirely inside, so make an empty range
+    ext.fullX1 = ext.touchX2 + 1;
+    ext.fullX2 = ext.touchX2;
+  }
+  return true;
+}
+
+uint8_t FootlegGraphics::edgeCoverage(float dx, float dy, float rad2,
+                                      float pixW, float pixH) {
+  // Approximate the distance of the edge from the pixel centre from the
+  // squared distance, and scale it by the pixel size across the edge to look
+  // up the coverage.
+  float across = 2 * (std::fabs(dx) * pixW + std::fabs(dy) * pixH);
+  if (across <= 0) return 255;
+  int idx = ((rad2 - dx * dx - dy * dy) / across + 0.5f) * COVERAGE_LUT_SIZE;
+  if (idx <= 0) return 0;
+  if (idx >= COVERAGE_LUT_SIZE) return 255;
+  return coverageLUT[idx];
+}
+
+void FootlegGraphics::drawCircleAA(float centreX, float centreY, float rad,
+                                   uint16_t pen) {
+  if (indexed) {
+    drawCircleAAPixels<uint8_t>(centreX, centreY, rad, pen);
+  } else {
+    drawCircleAAPixels<uint16_t>(centreX, centreY, rad, pen);
+  }
+}
+
+template <typename T>
+void FootlegGraphics::drawCircleAAPixels(float centreX, float centreY,
+                                         float rad, T pen) {
+  // Size of a buffer pixel in screen coordinates
+  float pixW = float(screen_width) / display->bounds.w;
+  float pixH = float(screen_height) / display->bounds.h;
+  float rad2 = rad * rad;
+  const Rect& clip = display->clip;
+  int clipX2 = clip.x + clip.w - 1;
+
+  // Rows of pixels touched by the circle, clipped to the drawing area
+  int y1 = std::floor((centreY - rad) / pixH);
+  int y2 = std::floor((centreY + rad) / pixH);
+  if (y1 < clip.y) y1 = clip.y;
+  if (y2 > clip.y + clip.h - 1) y2 = clip.y + clip.h - 1;
+
+  for (int y = y1; y <= y2; ++y) {
+    float dy = (y + 0.5f) * pixH - centreY;
+    RowExtent ext;
+    if (!circleRowExtent(centreX, dy, rad, pixW, pixH, ext)) continue;
+
+    // Clip the row to the drawing area
+    int x1 = ext.touchX1 < clip.x ? clip.x : ext.touchX1;
+    int x2 = ext.touchX2 > clipX2 ? clipX2 : ext.touchX2;
+    T* line = rowPointer<T>(y, x1, x2);
+
+    for (int x = x1; x <= x2; ++x) {
+      if (x >= ext.fullX1 && x <= ext.fullX2) {
+        // Fill the run of fully covered pixels
+        int end = ext.fullX2 < x2 ? ext.fullX2 : x2;
+        for (; x <= end; ++x) line[x] = pen;
+        x--;
+        continue;
+      }
+      uint8_t coverage =
+          edgeCoverage((x + 0.5f) * pixW - centreX, dy, rad2, pixW, pixH);
+      if (coverage == 255) {
+        line[x] = pen;
+      } else if (coverage > 0) {
+        line[x] = blend(line[x], pen, coverage);
+      }
+    }
+  }
+}
+
+void FootlegGraphics::drawRing(float centreX, float centreY, float innerRad,
+                               float outerRad, uint16_t innerPen,
+                               uint16_t ringPen) {
+  if (indexed) {
+    drawRingPixels<uint8_t>(centreX, centreY, innerRad, outerRad, innerPen,
+                            ringPen);
+  } else {
+    drawRingPixels<uint16_t>(centreX, centreY, innerRad, outerRad, innerPen,
+                             ringPen);
+  }
+}
+
+template <typename T>
+void FootlegGraphics::drawRingPixels(float centreX, float centreY,
+                                     float innerRad, float outerRad,
+                                     T innerPen, T ringPen) {
+  // Draws a disc of innerPen surrounded by a ring of ringPen, writing each
+  // pixel once. Pixels on the inner edge mix the two pens, and pixels on the
+  // outer edge are blended with the pixel already in the buffer.
+  float pixW = float(screen_width) / display->bounds.w;
+  float pixH = float(screen_height) / display->bounds.h;
+  float inner2 = innerRad * innerRad;
+  float outer2 = outerRad * outerRad;
+  const Rect& clip = display->clip;
+  int clipX2 = clip.x + clip.w - 1;
+
+  int y1 = std::floor((centreY - outerRad) / pixH);
+  int y2 = std::floor((centreY + outerRad) / pixH);
+  if (y1 < clip.y) y1 = clip.y;
+  if (y2 > clip.y + clip.h - 1) y2 = clip.y + clip.h - 1;
+
+  for (int y = y1; y <= y2; ++y) {
+    float dy = (y + 0.5f) * pixH - centreY;
+    RowExtent outer, inner;
+    if (!circleRowExtent(centreX, dy, outerRad, pixW, pixH, outer)) continue;
+    if (!circleRowExtent(centreX, dy, innerRad, pixW, pixH, inner)) {
+      // Row is outside the inner circle, so make empty ranges for it
+      inner.touchX1 = inner.fullX1 = outer.touchX2 + 1;
+      inner.touchX2 = inner.fullX2 = outer.touchX2;
+    }
+
+    int x1 = outer.touchX1 < clip.x ? clip.x : outer.touchX1;
+    int x2 = outer.touchX2 > clipX2 ? clipX2 : outer.touchX2;
+    T* line = rowPointer<T>(y, x1, x2);
+
+    for (int x = x1; x <= x2; ++x) {
+      bool inOuter = x >= outer.fullX1 && x <= outer.fullX2;
+      bool touchInner = x >= inner.touchX1 && x <= inner.touchX2;
+      if (x >= inner.fullX1 && x <= inner.fullX2) {
+        line[x] = innerPen;
+      } else if (inOuter && !touchInner) {
+        line[x] = ringPen;
+      } else {
+        float dx = (x + 0.5f) * pixW - centreX;
+        uint8_t covOuter =
+            inOuter ? 255 : edgeCoverage(dx, dy, outer2, pixW, pixH);
+        if (covOuter == 0) continue;
+        uint8_t covInner =
+            touchInner ? edgeCoverage(dx, dy, inner2, pixW, pixH) : 0;
+        // Mix of the two pens over the covered part of the pixel
+        T pen = ringPen;
+        if (covInner > 0) {
+          if (covInner >= covOuter) {
+            pen = innerPen;
+          } else {
+            pen = blend(ringPen, innerPen, covInner * 255 / covOuter);
+          }
+        }
+        line[x] = covOuter == 255 ? pen : blend(line[x], pen, covOuter);
+      }
+    }
+  }
+}
+
 void FootlegGraphics::drawCircle(int x, int y, int rad, uint16_t pen) {
   int rad_x, rad_y;
   Point position = Point(x * display->bounds.w / screen_width,
@@ -116,3 +414,446 @@ void FootlegGraphics::drawCircle(int x, int y, int rad, uint16_t pen) {
     display->circle(position, rad * display->bounds.w / screen_width);
   }
 }
+
+void FootlegGraphics::buildCircleRows(int rad, bool aa) {
+  circleRows.clear();
+  if (aa) {
+    // Same row geometry as drawCircleAA, relative to the centre pixel
+    float scaledRadY = rad * display->bounds.h / screen_height;
+    for (int y = 0; y <= scaledRadY; ++y) {
+      float yscaled2 = float(y * screen_height / display->bounds.h) *
+                       float(y * screen_height / display->bounds.h);
+      float x_limit =
+          std::sqrt(rad * rad - yscaled2) * display->bounds.w / screen_width;
+      float lineX = 0.5 - x_limit;
+      int iX1 = std::floor(lineX);
+      float spanX = 1 - (lineX - iX1);
+      CircleRow row;
+      if (spanX != 1) {
+        row.left = iX1 + 1;
+        row.right = int(std::floor(lineX + x_limit * 2)) - 1;
+        row.alpha = spanX * 255;
+      } else {
+        row.left = iX1;
+        row.right = iX1 + int(std::round(x_limit * 2)) - 1;
+        row.alpha = 0;
+      }
+      circleRows.push_back(row);
+    }
+  } else {
+    // Same row geometry as circle_scaled, relative to the centre pixel
+    int32_t radius_x = rad * display->bounds.w / screen_width;
+    int32_t radius_y = rad * display->bounds.h / screen_height;
+    if (rad == 1 || radius_x == 0 || radius_y == 0) {
+      circleRows.push_back({0, 0, 0});
+    } else {
+      for (int y = 0; y <= radius_y; ++y) {
+        double y_scaled = y / double(radius_y);
+        int x_limit = double(radius_x) * std::sqrt(1 - y_scaled * y_scaled);
+        circleRows.push_back({int16_t(-x_limit), int16_t(x_limit - 1), 0});
+      }
+    }
+  }
+  circleRowsRad = rad;
+  circleRowsAA = aa;
+}
+
+void FootlegGraphics::writeSpan(int x1, int x2, int y, uint16_t pen) {
+  // Writes pixels x1 to x2 inclusive, clipped to the drawing area
+  const Rect& clip = display->clip;
+  if (y < clip.y || y >= clip.y + clip.h) return;
+  if (x1 > x2) std::swap(x1, x2);
+  if (x1 < clip.x) x1 = clip.x;
+  if (x2 > clip.x + clip.w - 1) x2 = clip.x + clip.w - 1;
+
+  if (indexed) {
+    uint8_t* line = rowPointer<uint8_t>(y, x1, x2);
+    memset(line + x1, pen, x2 - x1 + 1);
+  } else {
+    uint16_t* line = rowPointer<uint16_t>(y, x1, x2);
+    for (int x = x1; x <= x2; ++x) line[x] = pen;
+  }
+}
+
+void FootlegGraphics::blendPixel(int x, int y, uint16_t pen, float coverage) {
+  const Rect& clip = display->clip;
+  if (x < clip.x || x >= clip.x + clip.w || y < clip.y ||
+      y >= clip.y + clip.h)
+    return;
+
+  if (indexed) {
+    blendPixelAt<uint8_t>(rowPointer<uint8_t>(y, x, x) + x, pen, coverage);
+  } else {
+    blendPixelAt<uint16_t>(rowPointer<uint16_t>(y, x, x) + x, pen, coverage);
+  }
+}
+
+template <typename T>
+void FootlegGraphics::blendPixelAt(T* pixel, T pen, float coverage) {
+  if (coverage >= 1) {
+    *pixel = pen;
+  } else if (coverage > 0) {
+    *pixel = blend(*pixel, pen, coverage * 255);
+  }
+}
+
+void FootlegGraphics::writeCircleRow(int cenX, int y, const CircleRow& row,
+                                     uint16_t pen, uint16_t penAA) {
+  const Rect& clip = display->clip;
+  if (y < clip.y || y >= clip.y + clip.h) return;
+
+  int clipX2 = clip.x + clip.w - 1;
+  int x1 = cenX + row.left;
+  int x2 = cenX + row.right;
+
+  if (row.alpha > 0) {
+    int aaX1 = x1 - 1 < clip.x ? clip.x : x1 - 1;
+    int aaX2 = x2 + 1 > clipX2 ? clipX2 : x2 + 1;
+    // Antialias end pixels into black only if background is black
+    if (indexed) {
+      writeEndPixels<uint8_t>(rowPointer<uint8_t>(y, aaX1, aaX2), x1 - 1,
+                              x2 + 1, penAA);
+    } else {
+      writeEndPixels<uint16_t>(rowPointer<uint16_t>(y, aaX1, aaX2), x1 - 1,
+                               x2 + 1, penAA);
+    }
+  }
+
+  writeSpan(x1, x2, y, pen);
+}
+
+template <typename T>
+void FootlegGraphics::writeEndPixels(T* line, int x1, int x2, T penAA) {
+  const Rect& clip = display->clip;
+  int clipX2 = clip.x + clip.w - 1;
+  if (x1 >= clip.x && x1 <= clipX2 && line[x1] == 0) line[x1] = penAA;
+  if (x2 >= clip.x && x2 <= clipX2 && line[x2] == 0) line[x2] = penAA;
+}
+
+void FootlegGraphics::sortByRadius(const CircleInstance* circles,
+                                   size_t count) {
+  circleOrder.resize(count);
+  for (size_t i = 0; i < count; ++i) circleOrder[i] = i;
+  std::sort(circleOrder.begin(), circleOrder.end(),
+            [circles](uint32_t a, uint32_t b) {
+              if (circles[a].r != circles[b].r)
+                return circles[a].r < circles[b].r;
+              return a < b;
+            });
+}
+
+void FootlegGraphics::drawCircles(const CircleInstance* circles, size_t count,
+                                  bool aa) {
+  // Sort into radius order, so the row spans for each radius are only
+  // calculated once per batch
+  sortByRadius(circles, count);
+
+  const Rect& clip = display->clip;
+  for (uint32_t idx : circleOrder) {
+    const CircleInstance& circle = circles[idx];
+    if (circle.r == 0) continue;
+
+    int cenX = circle.x * display->bounds.w / screen_width;
+    int cenY = circle.y * display->bounds.h / screen_height;
+
+    // Cull circles which are entirely outside the clip area
+    int extentX = circle.r * display->bounds.w / screen_width + 2;
+    int extentY = circle.r * display->bounds.h / screen_height + 2;
+    if (cenX + extentX < clip.x || cenX - extentX >= clip.x + clip.w ||
+        cenY + extentY < clip.y || cenY - extentY >= clip.y + clip.h)
+      continue;
+
+    if (circle.r != circleRowsRad || aa != circleRowsAA)
+      buildCircleRows(circle.r, aa);
+
+    for (size_t y = 0; y < circleRows.size(); ++y) {
+      const CircleRow& row = circleRows[y];
+      uint16_t penAA = 0;
+      if (row.alpha > 0) penAA = blendPen(0, circle.pen, row.alpha);
+      writeCircleRow(cenX, cenY - y, row, circle.pen, penAA);
+      if (y != 0) writeCircleRow(cenX, cenY + y, row, circle.pen, penAA);
+    }
+  }
+}
+
+void FootlegGraphics::drawLine(int x1, int y1, int x2, int y2, uint16_t pen) {
+  // Bresenham line in frame buffer pixels. Pixels on the same row are
+  // collected into a run and written as one span.
+  x1 = x1 * display->bounds.w / screen_width;
+  y1 = y1 * display->bounds.h / screen_height;
+  x2 = x2 * display->bounds.w / screen_width;
+  y2 = y2 * display->bounds.h / screen_height;
+
+  int dx = std::abs(x2 - x1);
+  int dy = -std::abs(y2 - y1);
+  int sx = x1 < x2 ? 1 : -1;
+  int sy = y1 < y2 ? 1 : -1;
+  int err = dx + dy;
+  int runX = x1;
+
+  while (x1 != x2 || y1 != y2) {
+    int e2 = 2 * err;
+    int nextX = x1;
+    if (e2 >= dy) {
+      err += dy;
+      nextX += sx;
+    }
+    if (e2 <= dx) {
+      // Moving onto the next row, so write out the run on this one
+      err += dx;
+      writeSpan(runX, x1, y1, pen);
+      runX = nextX;
+      y1 += sy;
+    }
+    x1 = nextX;
+  }
+  writeSpan(runX, x1, y1, pen);
+}
+
+void FootlegGraphics::drawLineAA(float x1, float y1, float x2, float y2,
+                                 uint16_t pen) {
+  // Xiaolin Wu's line algorithm in frame buffer pixels, blending a pair of
+  // pixels across the line at each step along it
+  x1 = x1 * display->bounds.w / screen_width;
+  y1 = y1 * display->bounds.h / screen_height;
+  x2 = x2 * display->bounds.w / screen_width;
+  y2 = y2 * display->bounds.h / screen_height;
+
+  bool steep = std::fabs(y2 - y1) > std::fabs(x2 - x1);
+  if (steep) {
+    std::swap(x1, y1);
+    std::swap(x2, y2);
+  }
+  if (x1 > x2) {
+    std::swap(x1, x2);
+    std::swap(y1, y2);
+  }
+  float gradient = x2 == x1 ? 1 : (y2 - y1) / (x2 - x1);
+
+  // Blend a pixel, swapping coordinates back for steep lines
+  auto plot = [this, steep, pen](int a, int b, float coverage) {
+    if (steep) {
+      blendPixel(b, a, pen, coverage);
+    } else {
+      blendPixel(a, b, pen, coverage);
+    }
+  };
+
+  // First end point, weighted by how much of its pixel the line covers
+  int xStart = std::round(x1);
+  float yEnd = y1 + gradient * (xStart - x1);
+  float gap = 1 - (x1 + 0.5f - std::floor(x1 + 0.5f));
+  int yPix = std::floor(yEnd);
+  float frac = yEnd - yPix;
+  plot(xStart, yPix, (1 - frac) * gap);
+  plot(xStart, yPix + 1, frac * gap);
+  float intery = yEnd + gradient;
+
+  // Second end point
+  int xFinish = std::round(x2);
+  yEnd = y2 + gradient * (xFinish - x2);
+  gap = x2 + 0.5f - std::floor(x2 + 0.5f);
+  yPix = std::floor(yEnd);
+  frac = yEnd - yPix;
+  plot(xFinish, yPix, (1 - frac) * gap);
+  plot(xFinish, yPix + 1, frac * gap);
+
+  // Pixels between the end points
+  for (int x = xStart + 1; x < xFinish; ++x) {
+    yPix = std::floor(intery);
+    frac = intery - yPix;
+    plot(x, yPix, 1 - frac);
+    plot(x, yPix + 1, frac);
+    intery += gradient;
+  }
+}
+
+void FootlegGraphics::drawPolyline(const Point* points, size_t count,
+                                   uint16_t pen, bool aa) {
+  for (size_t i = 1; i < count; ++i) {
+    if (aa) {
+      drawLineAA(points[i - 1].x, points[i - 1].y, points[i].x, points[i].y,
+                 pen);
+    } else {
+      drawLine(points[i - 1].x, points[i - 1].y, points[i].x, points[i].y,
+               pen);
+    }
+  }
+}
+
+// Light from the top left and in front of the screen, with the highlight
+// half way between the light and the viewer
+static const float LIGHT_X = -0.45f, LIGHT_Y = -0.55f, LIGHT_Z = 0.70f;
+
+void FootlegGraphics::buildHighlightLUT() {
+  // Highlight level for each step of the angle between the surface normal
+  // and the highlight direction, from the specular term (N.H)^24
+  for (int i = 0; i < HIGHLIGHT_LUT_SIZE; ++i) {
+    float specular = std::pow(float(i) / (HIGHLIGHT_LUT_SIZE - 1), 24);
+    int highlight = 0;
+    if (specular > 1.0f / SPHERE_HIGHLIGHTS) {
+      highlight = specular * SPHERE_HIGHLIGHTS;
+      if (highlight > SPHERE_HIGHLIGHTS) highlight = SPHERE_HIGHLIGHTS;
+    }
+    highlightLUT[i] = highlight;
+  }
+}
+
+FootlegGraphics::SphereTexel FootlegGraphics::lightTexel(int i, int j,
+                                                         int rad) {
+  const float hx = LIGHT_X / 2, hy = LIGHT_Y / 2, hz = (LIGHT_Z + 1) / 2;
+  const float hLen = std::sqrt(hx * hx + hy * hy + hz * hz);
+  const float AMBIENT = 0.2f;
+
+  float pixW = float(screen_width) / display->bounds.w;
+  float pixH = float(screen_height) / display->bounds.h;
+  float dx = i * pixW;
+  float dy = j * pixH;
+  SphereTexel texel;
+  texel.coverage = edgeCoverage(dx, dy, float(rad) * rad, pixW, pixH);
+  texel.shade = 0;
+  if (texel.coverage == 0) return texel;
+
+  // Work out the lighting of the pixel from the sphere surface normal
+  float nx = dx / rad;
+  float ny = dy / rad;
+  float nz2 = 1 - nx * nx - ny * ny;
+  float nz = nz2 > 0 ? std::sqrt(nz2) : 0;
+  float specular = (nx * hx + ny * hy + nz * hz) / hLen;
+  int highlight =
+      specular > 0 ? highlightLUT[int(specular * (HIGHLIGHT_LUT_SIZE - 1))]
+                   : 0;
+  if (highlight > 0) {
+    // Highlight, using the top of the ramp which blends towards white
+    texel.shade = SPHERE_SHADES + highlight - 1;
+  } else {
+    float diffuse = nx * LIGHT_X + ny * LIGHT_Y + nz * LIGHT_Z;
+    if (diffuse < 0) diffuse = 0;
+    float intensity = AMBIENT + (1 - AMBIENT) * diffuse;
+    texel.shade = std::round(intensity * (SPHERE_SHADES - 1));
+  }
+  return texel;
+}
+
+const std::vector<FootlegGraphics::SphereTexel>& FootlegGraphics::sphereTable(
+    int rad) {
+  // Use the table for this radius if there is one, or replace the one used
+  // least recently
+  sphereUseCount++;
+  SphereTable* table = &sphereTables[0];
+  for (SphereTable& t : sphereTables) {
+    if (t.rad == rad) {
+      t.lastUsed = sphereUseCount;
+      return t.texels;
+    }
+    if (t.lastUsed < table->lastUsed) table = &t;
+  }
+
+  int halfW, halfH;
+  sphereExtent(rad, halfW, halfH);
+  table->texels.resize((2 * halfW + 1) * (2 * halfH + 1));
+  SphereTexel* texel = table->texels.data();
+  for (int j = -halfH; j <= halfH; ++j) {
+    for (int i = -halfW; i <= halfW; ++i) *texel++ = lightTexel(i, j, rad);
+  }
+  table->rad = rad;
+  table->lastUsed = sphereUseCount;
+  return table->texels;
+}
+
+void FootlegGraphics::sphereExtent(int rad, int& halfW, int& halfH) {
+  halfW = std::ceil(rad * display->bounds.w / float(screen_width)) + 1;
+  halfH = std::ceil(rad * display->bounds.h / float(screen_height)) + 1;
+}
+
+void FootlegGraphics::drawSphere(int cenX, int cenY, int rad, uint16_t pen) {
+  if (indexed) {
+    drawSpherePixels<uint8_t>(cenX, cenY, rad, pen);
+  } else {
+    drawSpherePixels<uint16_t>(cenX, cenY, rad, pen);
+  }
+}
+
+template <typename T>
+void FootlegGraphics::drawSpherePixels(int cenX, int cenY, int rad, T pen) {
+  // Ramp of colours from black up to the pen colour, then on towards white
+  // for the highlight
+  T ramp[SPHERE_RAMP_SIZE];
+  for (int i = 0; i < SPHERE_SHADES; ++i) {
+    ramp[i] = blend(T(0), pen, i * 255 / (SPHERE_SHADES - 1));
+  }
+  for (int i = 0; i < SPHERE_HIGHLIGHTS; ++i) {
+    ramp[SPHERE_SHADES + i] =
+        blend(pen, T(whitePen), (i + 1) * 255 / SPHERE_HIGHLIGHTS);
+  }
+
+  // Spheres too large for a table are lit a row at a time as they are drawn
+  const SphereTexel* table =
+      rad <= SPHERE_MAX_TABLE_RAD ? sphereTable(rad).data() : nullptr;
+  int halfW, halfH;
+  sphereExtent(rad, halfW, halfH);
+
+  const Rect& clip = display->clip;
+  int width = 2 * halfW + 1;
+  for (int j = -halfH; j <= halfH; ++j) {
+    int y = cenY + j;
+    if (y < clip.y || y >= clip.y + clip.h) continue;
+
+    // Clip the row of texels to the drawing area
+    int i1 = -halfW;
+    int i2 = halfW;
+    if (cenX + i1 < clip.x) i1 = clip.x - cenX;
+    if (cenX + i2 > clip.x + clip.w - 1) i2 = clip.x + clip.w - 1 - cenX;
+
+    if (i1 > i2) continue;
+
+    const SphereTexel* texel;
+    if (table) {
+      texel = &table[(j + halfH) * width + i1 + halfW];
+    } else {
+      sphereRow.resize(i2 - i1 + 1);
+      for (int i = i1; i <= i2; ++i) sphereRow[i - i1] = lightTexel(i, j, rad);
+      texel = sphereRow.data();
+    }
+    T* line = rowPointer<T>(y, cenX + i1, cenX + i2);
+    for (int i = i1; i <= i2; ++i, ++texel) {
+      if (texel->coverage == 255) {
+        line[cenX + i] = ramp[texel->shade];
+      } else if (texel->coverage > 0) {
+        line[cenX + i] =
+            blend(line[cenX + i], ramp[texel->shade], texel->coverage);
+      }
+    }
+  }
+}
+
+void FootlegGraphics::drawShadedSphere(int x, int y, int rad, uint16_t pen) {
+  if (rad <= 0) return;
+  drawSphere(x * display->bounds.w / screen_width,
+             y * display->bounds.h / screen_height, rad, pen);
+}
+
+void FootlegGraphics::drawSpheres(const CircleInstance* circles,
+                                  size_t count) {
+  // Sort into radius order, so spheres of the same radius are drawn one after
+  // another from the same lighting table
+  sortByRadius(circles, count);
+
+  const Rect& clip = display->clip;
+  for (uint32_t idx : circleOrder) {
+    const CircleInstance& circle = circles[idx];
+    if (circle.r == 0) continue;
+
+    int cenX = circle.x * display->bounds.w / screen_width;
+    int cenY = circle.y * display->bounds.h / screen_height;
+
+    // Cull spheres which are entirely outside the clip area
+    int extentX = circle.r * display->bounds.w / screen_width + 2;
+    int extentY = circle.r * display->bounds.h / screen_height + 2;
+    if (cenX + extentX < clip.x || cenX - extentX >= clip.x + clip.w ||
+        cenY + extentY < clip.y || cenY - extentY >= clip.y + clip.h)
+      continue;
+
+    drawSphere(cenX, cenY, circle.r, circle.pen);
+  }
+}
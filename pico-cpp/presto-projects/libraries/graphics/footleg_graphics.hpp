@@ -6,26 +6,174 @@
  * double width or double height pixels so they appear round when the
  * graphics buffer is stretched to the full screen resolution.
  *
+ * Drawing can also be done into an 8 bit palette buffer, which takes half the
+ * memory of an RGB565 buffer. Pens for this should be made with createPen(),
+ * which gives each colour a ramp of shades in the palette for AA edges to
+ * blend along.
+ *
  * Copyright (c) 2025 Dr Footleg
  *
  * License: GNU GPL v3.0
  */
+#pragma once
+
+#include <stddef.h>
+
+#include <vector>
+
 #include "libraries/pico_graphics/pico_graphics.hpp"
+#include "line_cache.hpp"
 
 using namespace pimoroni;
 
+// A circle to be drawn by drawCircles(). Position and radius are in 480 x 480
+// screen coordinates, the same as the single circle drawing methods.
+struct CircleInstance {
+  int16_t x;
+  int16_t y;
+  uint16_t r;
+  uint16_t pen;
+};
+
 class FootlegGraphics {
  public:
   FootlegGraphics(PicoGraphics_PenRGB565* display, uint16_t* screen_buffer);
+  FootlegGraphics(PicoGraphics_PenP8* display, uint8_t* screen_buffer);
+  // Create a pen which AA edges can blend into black. In a palette buffer
+  // this uses PALETTE_RAMP_SIZE palette entries.
+  uint16_t createPen(uint8_t r, uint8_t g, uint8_t b);
   void circle_scaled(const Point& p, int32_t radius_x, int32_t radius_y);
   void drawAASpan(float x, int y, float width, uint16_t pen);
   void drawCircleAA(int centreX, int centreY, int rad, uint16_t pen);
+  void drawCircleAA(float centreX, float centreY, float rad, uint16_t pen);
   void drawCircle(int x, int y, int rad, uint16_t pen);
+  void drawRing(float centreX, float centreY, float innerRad, float outerRad,
+                uint16_t innerPen, uint16_t ringPen);
+  // Circles are drawn smallest first, and in array order for circles of the
+  // same radius. Where circles of different sizes overlap, the larger one is
+  // drawn on top, whatever order the separate calls would have used.
+  void drawCircles(const CircleInstance* circles, size_t count,
+                   bool aa = true);
+  void drawShadedSphere(int x, int y, int rad, uint16_t pen);
+  // Drawn in the same order as drawCircles
+  void drawSpheres(const CircleInstance* circles, size_t count);
+  void drawLine(int x1, int y1, int x2, int y2, uint16_t pen);
+  void drawLineAA(float x1, float y1, float x2, float y2, uint16_t pen);
+  void drawPolyline(const Point* points, size_t count, uint16_t pen,
+                    bool aa = false);
+  // Draw through a line cache instead of straight into the frame buffer
+  void setLineCache(LineCache* cache);
+
+  // Palette entries used by each pen made by createPen() in a palette buffer
+  static constexpr int PALETTE_RAMP_SIZE = 8;
 
  private:
-  PicoGraphics_PenRGB565* display;
-  uint16_t* screen_buffer;
+  // One row of a circle relative to its centre pixel. Pixels from left to
+  // right are drawn solid, with optional AA pixels just outside each end.
+  struct CircleRow {
+    int16_t left;
+    int16_t right;
+    uint8_t alpha;  // Coverage of the AA end pixels (0 = no AA pixels)
+  };
+
+  // Pixel coverage by an edge, indexed by the distance of the edge from the
+  // pixel centre (as a fraction of the pixel size across the edge)
+  static constexpr int COVERAGE_LUT_SIZE = 64;
+
+  // Shaded spheres use a ramp of colours from black to the sphere colour,
+  // followed by highlight colours blending from the sphere colour to white
+  static constexpr int SPHERE_SHADES = 24;
+  static constexpr int SPHERE_HIGHLIGHTS = 8;
+  static constexpr int SPHERE_RAMP_SIZE = SPHERE_SHADES + SPHERE_HIGHLIGHTS;
+  // Lighting tables are kept for this many radii, so mixed sizes of sphere
+  // (and zooming) do not rebuild them for every sphere
+  static constexpr int SPHERE_TABLE_COUNT = 6;
+  // Larger spheres are lit a row at a time as they are drawn, as their tables
+  // would take too much memory (in 480 x 480 screen pixels)
+  static constexpr int SPHERE_MAX_TABLE_RAD = 40;
+  // Steps of the specular term looked up for the highlight level
+  static constexpr int HIGHLIGHT_LUT_SIZE = 256;
+
+  // Lighting of one pixel of a shaded sphere. Shade indexes the colour ramp
+  // and coverage is how much of the pixel is inside the sphere edge.
+  struct SphereTexel {
+    uint8_t shade;
+    uint8_t coverage;
+  };
+
+  // Lighting of every pixel of a sphere of one radius
+  struct SphereTable {
+    int rad = -1;
+    uint32_t lastUsed = 0;
+    std::vector<SphereTexel> texels;
+  };
+
+  // Columns of one row of pixels touched by, and entirely inside, a circle
+  struct RowExtent {
+    int touchX1, touchX2;
+    int fullX1, fullX2;
+  };
+
+  PicoGraphics* display;
+  void* screen_buffer;
   uint16_t screen_width = 480;
   uint16_t screen_height = 480;
+  LineCache* lineCache = nullptr;
+  bool indexed = false;  // Whether pens are palette indices
+  bool penSwapped;       // Whether pens are byte swapped RGB565
+  uint8_t rampLevel[256] = {};  // Shade of each palette entry in its ramp
+  uint16_t whitePen;
+  uint8_t coverageLUT[COVERAGE_LUT_SIZE];
+  std::vector<CircleRow> circleRows;  // Row spans for circleRowsRad
+  int circleRowsRad = -1;
+  bool circleRowsAA = false;
+  std::vector<uint32_t> circleOrder;  // Batch draw order by radius
+  SphereTable sphereTables[SPHERE_TABLE_COUNT];
+  uint32_t sphereUseCount = 0;
+  std::vector<SphereTexel> sphereRow;  // One row of a sphere too large for a
+                                       // table
+  uint8_t highlightLUT[HIGHLIGHT_LUT_SIZE];
   void drawPixelSpan(Point p, int width);
+  template <typename T>
+  T* rowPointer(int y, int x1, int x2);
+  bool blankPixel(int x, int y);
+  void buildCoverageLUT();
+  uint16_t blendPen(uint16_t bg, uint16_t fg, uint8_t alpha);
+  uint16_t blendRGB565(uint16_t bg, uint16_t fg, uint8_t alpha);
+  uint8_t blendIndex(uint8_t bg, uint8_t fg, uint8_t alpha);
+  // Blend for the pixel type being drawn
+  uint16_t blend(uint16_t bg, uint16_t fg, uint8_t alpha) {
+    return blendRGB565(bg, fg, alpha);
+  }
+  uint8_t blend(uint8_t bg, uint8_t fg, uint8_t alpha) {
+    return blendIndex(bg, fg, alpha);
+  }
+  bool circleRowExtent(float centreX, float dy, float rad, float pixW,
+                       float pixH, RowExtent& ext);
+  uint8_t edgeCoverage(float dx, float dy, float rad2, float pixW, float pixH);
+  void sortByRadius(const CircleInstance* circles, size_t count);
+  void buildCircleRows(int rad, bool aa);
+  void buildHighlightLUT();
+  SphereTexel lightTexel(int i, int j, int rad);
+  const std::vector<SphereTexel>& sphereTable(int rad);
+  // Texels either side of the centre pixel of a sphere
+  void sphereExtent(int rad, int& halfW, int& halfH);
+  void drawSphere(int cenX, int cenY, int rad, uint16_t pen);
+  void writeSpan(int x1, int x2, int y, uint16_t pen);
+  void blendPixel(int x, int y, uint16_t pen, float coverage);
+  void writeCircleRow(int cenX, int y, const CircleRow& row, uint16_t pen,
+                      uint16_t penAA);
+
+  // Pixel loops for each type of buffer, with T the pixel type
+  template <typename T>
+  void drawCircleAAPixels(float centreX, float centreY, float rad, T pen);
+  template <typename T>
+  void drawRingPixels(float centreX, float centreY, float innerRad,
+                      float outerRad, T innerPen, T ringPen);
+  template <typename T>
+  void drawSpherePixels(int cenX, int cenY, int rad, T pen);
+  template <typename T>
+  void blendPixelAt(T* pixel, T pen, float coverage);
+  template <typename T>
+  void writeEndPixels(T* line, int x1, int x2, T penAA);
 };
@@ -0,0 +1,106 @@
+/*
+ * A write-combining cache of whole rows for a drawing buffer held in slow
+ * memory such as PSRAM. Drawing goes into rows held in a small SRAM buffer,
+ * and only the span of each row which was drawn on is written back, as a
+ * single burst when the row leaves the cache. Rows are only read from the
+ * buffer when pixels are read back (e.g. for anti-aliased edges), so clearing
+ * and filling rows costs no reads at all.
+ *
+ * Copyright (c) 2025 Dr Footleg
+ *
+ * License: GNU GPL v3.0
+ */
+#include "line_cache.hpp"
+
+#include <string.h>
+
+LineCache::LineCache(uint16_t* buffer, uint16_t width, uint16_t height,
+                     uint16_t* line_buffer, uint16_t lines)
+    : buffer(buffer),
+      width(width),
+      height(height),
+      line_buffer(line_buffer),
+      lines(lines > MAX_LINES ? MAX_LINES : lines) {
+  for (int i = 0; i < this->lines; i++) {
+    lineInfo[i] = {-1, false, 0, -1};
+  }
+};
+
+uint16_t* LineCache::row(int y, int x1, int x2) {
+  return fetch(y, x1, x2, true);
+}
+
+uint16_t* LineCache::writeRow(int y, int x1, int x2) {
+  return fetch(y, x1, x2, false);
+}
+
+uint16_t* LineCache::fetch(int y, int x1, int x2, bool read) {
+  // Rows map directly to cache lines, which suits drawing shapes row by row
+  int index = y % lines;
+  Line& line = lineInfo[index];
+  uint16_t* pixels = line_buffer + index * width;
+  if (line.y != y) {
+    writeBack(line, pixels);
+    line = {int16_t(y), false, 0, -1};
+  }
+  if (x1 > x2) return pixels;
+
+  if (!line.loaded) {
+    // Pixels outside the dirty span are not in the cache yet. They are
+    // needed if they are to be read, or if the new span is not joined to the
+    // dirty span (as everything in between would be written back).
+    bool joined = line.dirtyX2 < line.dirtyX1 ||
+                  (x1 <= line.dirtyX2 + 1 && x2 >= line.dirtyX1 - 1);
+    bool covered = x1 >= line.dirtyX1 && x2 <= line.dirtyX2;
+    if ((read && !covered) || !joined) load(line, pixels);
+  }
+  if (x1 < line.dirtyX1 || line.dirtyX2 < line.dirtyX1) line.dirtyX1 = x1;
+  if (x2 > line.dirtyX2) line.dirtyX2 = x2;
+  return pixels;
+}
+
+void LineCache::load(Line& line, uint16_t* pixels) {
+  // Read the row around the dirty span, keeping the drawing in the cache
+  const uint16_t* src = buffer + line.y * width;
+  if (line.dirtyX2 < line.dirtyX1) {
+    memcpy(pixels, src, width * sizeof(uint16_t));
+  } else {
+    memcpy(pixels, src, line.dirtyX1 * sizeof(uint16_t));
+    memcpy(pixels + line.dirtyX2 + 1, src + line.dirtyX2 + 1,
+           (width - line.dirtyX2 - 1) * sizeof(uint16_t));
+  }
+  line.loaded = true;
+}
+
+void LineCache::writeBack(Line& line, uint16_t* pixels) {
+  if (line.y < 0 || line.dirtyX2 < line.dirtyX1) return;
+  memcpy(buffer + line.y * width + line.dirtyX1, pixels + line.dirtyX1,
+         (line.dirtyX2 - line.dirtyX1 + 1) * sizeof(uint16_t));
+}
+
+void LineCache::flush() {
+  for (int i = 0; i < lines; i++) {
+    writeBack(lineInfo[i], line_buffer + i * width);
+    lineInfo[i] = {-1, false, 0, -1};
+  }
+}
+
+void CachedPenRGB565::set_pixel(const Point& p) {
+  if (!cache) {
+    PicoGraphics_PenRGB565::set_pixel(p);
+    return;
+  }
+  cache->writeRow(p.y, p.x, p.x)[p.x] = color;
+}
+
+void CachedPenRGB565::set_pixel_span(const Point& p, uint l) {
+  if (!cache) {
+    PicoGraphics_PenRGB565::set_pixel_span(p, l);
+    return;
+  }
+  if (l == 0) return;
+  uint16_t* pixels = cache->writeRow(p.y, p.x, p.x + l - 1) + p.x;
+  while (l--) {
+    *pixels++ = color;
+  }
+}
@@ -0,0 +1,73 @@
+/*
+ * A write-combining cache of whole rows for a drawing buffer held in slow
+ * memory such as PSRAM. Drawing goes into rows held in a small SRAM buffer,
+ * and only the span of each row which was drawn on is written back, as a
+ * single burst when the row leaves the cache. Rows are only read from the
+ * buffer when pixels are read back (e.g. for anti-aliased edges), so clearing
+ * and filling rows costs no reads at all.
+ *
+ * CachedPenRGB565 is a Pico Graphics RGB565 display which draws through the
+ * cache, and FootlegGraphics::setLineCache() routes the Footleg Graphics
+ * drawing through the same cache.
+ *
+ * Copyright (c) 2025 Dr Footleg
+ *
+ * License: GNU GPL v3.0
+ */
+#pragma once
+
+#include <stdint.h>
+
+#include "libraries/pico_graphics/pico_graphics.hpp"
+
+using namespace pimoroni;
+
+class LineCache {
+ public:
+  // line_buffer must hold lines rows of width pixels, and should be in SRAM
+  LineCache(uint16_t* buffer, uint16_t width, uint16_t height,
+            uint16_t* line_buffer, uint16_t lines);
+
+  // Row y, for reading and writing pixels x1 to x2. The pointer is to pixel 0
+  // of the row, and stays valid until another row is accessed.
+  uint16_t* row(int y, int x1, int x2);
+  // Row y, for pixels x1 to x2 which will all be overwritten without reading
+  uint16_t* writeRow(int y, int x1, int x2);
+  // Write all drawing back to the buffer and empty the cache
+  void flush();
+
+ private:
+  static const uint16_t MAX_LINES = 64;
+
+  // A cached row. Only pixels dirtyX1 to dirtyX2 are valid unless the rest
+  // of the row has been loaded.
+  struct Line {
+    int16_t y;
+    bool loaded;
+    int16_t dirtyX1, dirtyX2;
+  };
+
+  uint16_t* buffer;
+  uint16_t width;
+  uint16_t height;
+  uint16_t* line_buffer;
+  uint16_t lines;
+  Line lineInfo[MAX_LINES];
+  uint16_t* fetch(int y, int x1, int x2, bool read);
+  void load(Line& line, uint16_t* pixels);
+  void writeBack(Line& line, uint16_t* pixels);
+};
+
+// Pico Graphics RGB565 display drawing through a line cache. With no cache
+// set it draws straight into the frame buffer as normal.
+class CachedPenRGB565 : public PicoGraphics_PenRGB565 {
+ public:
+  CachedPenRGB565(uint16_t width, uint16_t height, void* frame_buffer)
+      : PicoGraphics_PenRGB565(width, height, frame_buffer) {};
+  void setCache(LineCache* cache) { this->cache = cache; }
+  void set_pixel(const Point& p) override;
+  void set_pixel_span(const Point& p, uint l) override;
+
+ private:
+  LineCache* cache = nullptr;
+};
@@ -0,0 +1,71 @@
+/*
+ * Loads Game of Life pattern files from the SD card.
+ *
+ * Copyright (c) 2025 Dr Footleg
+ *
+ * License: GNU GPL v3.0
+ */
+#include "life_loader.hpp"
+
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+
+#include "ff.h"
+#include "pico/time.h"
+
+// Bytes read from the card at a time. A multiple of the card sector size.
+static const uint32_t LOAD_CHUNK_SIZE = 4096;
+
+static FATFS fs;
+static bool mounted = false;
+
+bool mountLifeCard() {
+  if (!mounted) mounted = f_mount(&fs, "", 1) == FR_OK;
+  return mounted;
+}
+
+static bool isPatternFile(const char* name) {
+  const char* ext = strrchr(name, '.');
+  return ext &&
+         (strcasecmp(ext, ".rle") == 0 || strcasecmp(ext, ".cells") == 0);
+}
+
+bool findLifePattern(const char* directory, char* path, uint16_t pathSize) {
+  if (!mountLifeCard()) return false;
+  DIR dir;
+  FILINFO info;
+  if (f_opendir(&dir, directory) != FR_OK) return false;
+  bool found = false;
+  while (!found && f_readdir(&dir, &info) == FR_OK && info.fname[0]) {
+    if (!(info.fattrib & AM_DIR) && isPatternFile(info.fname)) {
+      snprintf(path, pathSize, "%s/%s", directory, info.fname);
+      found = true;
+    }
+  }
+  f_closedir(&dir);
+  return found;
+}
+
+bool loadLifePattern(const char* path, LifeParser& parser,
+                     LifeLoadStats& stats) {
+  static char buffer[LOAD_CHUNK_SIZE];
+  stats.bytes = 0;
+  stats.timeUs = 0;
+  if (!mountLifeCard()) return false;
+
+  uint64_t start = time_us_64();
+  FIL file;
+  if (f_open(&file, path, FA_READ) != FR_OK) return false;
+  UINT read = 0;
+  FRESULT result;
+  while ((result = f_read(&file, buffer, sizeof(buffer), &read)) == FR_OK &&
+         read > 0) {
+    parser.feed(buffer, read);
+    stats.bytes += read;
+    if (parser.isDone()) break;
+  }
+  f_close(&file);
+  stats.timeUs = time_us_64() - start;
+  return result == FR_OK;
+}
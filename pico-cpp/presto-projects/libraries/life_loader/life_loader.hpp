@@ -0,0 +1,31 @@
+/*
+ * Loads Game of Life pattern files from the SD card, streaming each file
+ * through a LifeParser a chunk at a time.
+ *
+ * Copyright (c) 2025 Dr Footleg
+ *
+ * License: GNU GPL v3.0
+ */
+#pragma once
+
+#include <stdint.h>
+
+#include "life_parser.hpp"
+
+struct LifeLoadStats {
+  uint32_t bytes;   // Bytes read from the file
+  uint32_t timeUs;  // Time taken to read and parse the file
+};
+
+// Mount the SD card, if it is not mounted already. Returns false if there is
+// no card or it cannot be read.
+bool mountLifeCard();
+
+// Find the first pattern file (.rle or .cells) in a directory on the SD card.
+// Returns false if there are none.
+bool findLifePattern(const char* directory, char* path, uint16_t pathSize);
+
+// Read a pattern file from the SD card into a parser. Returns false if the
+// file could not be read.
+bool loadLifePattern(const char* path, LifeParser& parser,
+                     LifeLoadStats& stats);
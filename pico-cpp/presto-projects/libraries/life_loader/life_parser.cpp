@@ -0,0 +1,149 @@
+/*
+ * Streaming parser for Game of Life pattern files in the run length encoded
+ * (.rle) and plaintext (.cells) formats.
+ *
+ * Copyright (c) 2025 Dr Footleg
+ *
+ * License: GNU GPL v3.0
+ */
+#include "life_parser.hpp"
+
+#include <stdlib.h>
+#include <string.h>
+
+LifeParser::LifeParser(CellCallback setCell, void* context, uint32_t originX,
+                       uint32_t originY)
+    : setCell(setCell), context(context), originX(originX), originY(originY) {}
+
+void LifeParser::centreOn(uint32_t x, uint32_t y) {
+  centre = true;
+  centreX = x;
+  centreY = y;
+}
+
+void LifeParser::feed(const char* data, size_t length) {
+  for (size_t i = 0; i < length && !done; i++) parseChar(data[i]);
+}
+
+void LifeParser::parseChar(char c) {
+  if (c == '\r') return;
+  if (skipLine) {
+    if (c == '\n') {
+      skipLine = false;
+      lineStart = true;
+    }
+    return;
+  }
+  if (inHeader) {
+    if (c == '\n') {
+      header[headerLength] = 0;
+      parseHeader();
+      inHeader = false;
+      lineStart = true;
+    } else if (headerLength < sizeof(header) - 1) {
+      header[headerLength++] = c;
+    }
+    return;
+  }
+
+  if (lineStart) {
+    // Comment lines start with # in RLE files and ! in plaintext files, but !
+    // also ends the pattern in RLE files
+    if (c == '#' || (c == '!' && format != FORMAT_RLE)) {
+      if (c == '!') format = FORMAT_PLAINTEXT;
+      skipLine = true;
+      return;
+    }
+    if (format == FORMAT_UNKNOWN) {
+      if (c == ' ' || c == '\t' || c == '\n') return;
+      if (c == 'x') {
+        format = FORMAT_RLE;
+        inHeader = true;
+        header[0] = c;
+        headerLength = 1;
+        return;
+      }
+      format = (c == '.' || c == 'O' || c == '*') ? FORMAT_PLAINTEXT
+                                                  : FORMAT_RLE;
+    }
+    lineStart = false;
+  }
+
+  if (format == FORMAT_RLE) {
+    parseRLE(c);
+  } else {
+    parsePlaintext(c);
+  }
+}
+
+void LifeParser::parseHeader() {
+  // Header looks like "x = 36, y = 9, rule = B3/S23"
+  const char* field = header;
+  while (field && *field) {
+    while (*field == ' ' || *field == ',') field++;
+    char name = *field;
+    const char* equals = strchr(field, '=');
+    if (!equals) break;
+    uint32_t value = strtoul(equals + 1, nullptr, 10);
+    if (name == 'x') width = value;
+    if (name == 'y') height = value;
+    field = strchr(equals, ',');
+  }
+  if (centre) {
+    originX = centreX - width / 2;
+    originY = centreY - height / 2;
+  }
+}
+
+void LifeParser::parseRLE(char c) {
+  if (c >= '0' && c <= '9') {
+    count = count * 10 + (c - '0');
+    return;
+  }
+  if (c == '\n') {
+    lineStart = true;
+    return;
+  }
+  if (c == ' ' || c == '\t') return;
+
+  uint32_t run = count ? count : 1;
+  count = 0;
+  if (c == 'b' || c == '.') {
+    x += run;
+  } else if (c == '$') {
+    y += run;
+    x = 0;
+  } else if (c == '!') {
+    done = true;
+  } else if (c >= 'p' && c <= 'y') {
+    // First letter of a two letter state in a multi-state file. The run
+    // applies to the state letter which follows.
+    count = run;
+  } else {
+    // o, or any other live state in a multi-state file
+    addCells(run);
+  }
+}
+
+void LifeParser::parsePlaintext(char c) {
+  if (c == '\n') {
+    y++;
+    x = 0;
+    lineStart = true;
+    if (y > height) height = y;
+  } else if (c == 'O' || c == '*') {
+    addCells(1);
+    if (y + 1 > height) height = y + 1;
+  } else {
+    x++;
+  }
+}
+
+void LifeParser::addCells(uint32_t run) {
+  for (uint32_t i = 0; i < run; i++) {
+    setCell(context, originX + x + i, originY + y);
+  }
+  x += run;
+  liveCells += run;
+  if (x > width) width = x;
+}
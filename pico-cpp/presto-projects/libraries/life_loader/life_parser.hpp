@@ -0,0 +1,70 @@
+/*
+ * Streaming parser for Game of Life pattern files in the run length encoded
+ * (.rle) and plaintext (.cells) formats. The file is fed in as chunks of any
+ * size, and each live cell is passed straight on to a callback as it is
+ * decoded, so even very large patterns can be loaded without holding the file
+ * in memory.
+ *
+ * Copyright (c) 2025 Dr Footleg
+ *
+ * License: GNU GPL v3.0
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+class LifeParser {
+ public:
+  typedef void (*CellCallback)(void* context, uint32_t x, uint32_t y);
+
+  // Live cells are passed to setCell offset by originX and originY
+  LifeParser(CellCallback setCell, void* context, uint32_t originX = 0,
+             uint32_t originY = 0);
+
+  // Place the pattern so its centre is on this cell, rather than its top left
+  // at the origin. Only possible for RLE files, which give the pattern size in
+  // the header before any cells.
+  void centreOn(uint32_t x, uint32_t y);
+
+  void feed(const char* data, size_t length);
+
+  // True once the end of the pattern has been reached. Any data after this
+  // is ignored.
+  bool isDone() { return done; }
+
+  uint32_t getWidth() { return width; }
+  uint32_t getHeight() { return height; }
+  uint32_t getLiveCells() { return liveCells; }
+
+ private:
+  enum Format { FORMAT_UNKNOWN, FORMAT_RLE, FORMAT_PLAINTEXT };
+
+  CellCallback setCell;
+  void* context;
+  uint32_t originX;
+  uint32_t originY;
+  bool centre = false;
+  uint32_t centreX;
+  uint32_t centreY;
+
+  Format format = FORMAT_UNKNOWN;
+  bool done = false;
+  bool lineStart = true;
+  bool skipLine = false;  // In a comment line
+  bool inHeader = false;  // In the RLE header line
+  char header[96];
+  uint8_t headerLength = 0;
+  uint32_t count = 0;  // RLE run count read so far
+  uint32_t x = 0;
+  uint32_t y = 0;
+  uint32_t width = 0;
+  uint32_t height = 0;
+  uint32_t liveCells = 0;
+
+  void parseChar(char c);
+  void parseHeader();
+  void parseRLE(char c);
+  void parsePlaintext(char c);
+  void addCells(uint32_t run);
+};
@@ -0,0 +1,351 @@
+/*
+ * Presents a drawing buffer onto the Presto scan-out buffer. The drawing
+ * buffer does not need to match the resolution of the scan-out buffer. A
+ * smaller buffer (e.g. 240 x 240) is upscaled during the copy, using the
+ * RP2350 hardware interpolator to generate the source pixel addresses. This
+ * allows square pixels to be drawn into a quarter of the memory of a full
+ * resolution buffer.
+ *
+ * Copyright (c) 2025 Dr Footleg
+ *
+ * License: GNU GPL v3.0
+ */
+#include "presenter.hpp"
+
+#include <string.h>
+
+#include "hardware/dma.h"
+#include "hardware/interp.h"
+#include "hardware/sync.h"
+
+Presenter::Presenter(uint16_t* screen_buffer, uint16_t screen_width,
+                     uint16_t screen_height)
+    : screen_buffer(screen_buffer),
+      screen_width(screen_width),
+      screen_height(screen_height) {};
+
+void Presenter::upscale(PicoGraphics_PenRGB565* display) {
+  upscale(display, 0, display->bounds.h);
+}
+
+void Presenter::upscale(PicoGraphics_PenRGB565* display, uint16_t first_row,
+                        uint16_t last_row) {
+  upscale((const uint16_t*)display->frame_buffer, display->bounds.w,
+          display->bounds.h, first_row, last_row);
+}
+
+void Presenter::upscale(const uint16_t* src, uint16_t src_width,
+                        uint16_t src_height) {
+  upscale(src, src_width, src_height, 0, src_height);
+}
+
+void Presenter::upscale(const uint16_t* src, uint16_t src_width,
+                        uint16_t src_height, uint16_t first_row,
+                        uint16_t last_row) {
+  if (last_row > src_height) last_row = src_height;
+  if (first_row >= last_row) return;
+
+  // Range of screen rows which show the source rows (rounding up so a screen
+  // row belongs to the source row it was scaled from)
+  int first_y = (first_row * screen_height + src_height - 1) / src_height;
+  int last_y = (last_row * screen_height + src_height - 1) / src_height;
+
+  if (src_width == screen_width && src_height == screen_height) {
+    // Same resolution, so nothing to scale
+    memcpy(screen_buffer + first_y * screen_width, src + first_y * src_width,
+           (last_y - first_y) * screen_width * sizeof(uint16_t));
+    return;
+  }
+
+  // Find the number of bits needed to index a pixel in a source row
+  uint mask_bits = 1;
+  while ((1u << mask_bits) < src_width) mask_bits++;
+
+  // Lane 0 steps through the source row in 16.16 fixed point. The shift
+  // converts the integer part into a byte offset for 16 bit pixels, and the
+  // full result adds this to the row address held in base 2. Lane 1 is left
+  // at zero so it adds nothing to the full result.
+  interp_config cfg = interp_default_config();
+  interp_config_set_add_raw(&cfg, true);
+  interp_config_set_shift(&cfg, 16 - 1);
+  interp_config_set_mask(&cfg, 1, mask_bits);
+  interp_set_config(interp0, 0, &cfg);
+  interp_set_config(interp0, 1, &cfg);
+  interp0->accum[1] = 0;
+  interp0->base[1] = 0;
+
+  uint32_t step = ((uint32_t)src_width << 16) / screen_width;
+  int lastSrcY = -1;
+  for (int y = first_y; y < last_y; ++y) {
+    int srcY = y * src_height / screen_height;
+    uint16_t* dst_row = screen_buffer + y * screen_width;
+    if (srcY == lastSrcY) {
+      // Repeated row, so copy the row we already scaled
+      memcpy(dst_row, dst_row - screen_width, screen_width * sizeof(uint16_t));
+    } else {
+      upscaleRow(src + srcY * src_width, dst_row, step);
+      lastSrcY = srcY;
+    }
+  }
+}
+
+void Presenter::presentAsync(PicoGraphics_PenRGB565* display) {
+  RowRange all = {0, uint16_t(display->bounds.h)};
+  presentAsync(display, &all, 1);
+}
+
+void Presenter::presentAsync(PicoGraphics_PenRGB565* display,
+                             const RowRange* ranges, size_t count) {
+  if (display->bounds.w != screen_width || display->bounds.h != screen_height) {
+    // Upscaled by the CPU, so any clear of the buffer must finish first
+    waitForDma();
+    for (size_t i = 0; i < count; i++) {
+      upscale(display, ranges[i].first, ranges[i].last);
+    }
+    return;
+  }
+  startDma((const uint16_t*)display->frame_buffer, true, screen_buffer,
+           screen_width, screen_height, ranges, count);
+}
+
+void Presenter::clearAsync(PicoGraphics_PenRGB565* display, uint16_t pen) {
+  RowRange all = {0, uint16_t(display->bounds.h)};
+  clearAsync(display, pen, &all, 1);
+}
+
+void Presenter::clearAsync(PicoGraphics_PenRGB565* display, uint16_t pen,
+                           const RowRange* ranges, size_t count) {
+  // Queued behind any present of the buffer still running, so this never
+  // waits for it. Only a clear in another colour waits, as a clear still
+  // queued may be reading the fill word.
+  uint32_t word = pen | (uint32_t)pen << 16;
+  if (word != fillWord) waitForDma();
+  fillWord = word;
+  startDma((const uint16_t*)&fillWord, false,
+           (uint16_t*)display->frame_buffer, display->bounds.w,
+           display->bounds.h, ranges, count);
+}
+
+void Presenter::setPalette(PicoGraphics_PenP8* display) {
+  for (int i = 0; i < PicoGraphics_PenP8::palette_size; i++) {
+    const RGB& c = display->palette[i];
+    paletteLUT[i] = RGB(c.r, c.g, c.b).to_rgb565();
+  }
+}
+
+void Presenter::presentAsync(PicoGraphics_PenP8* display) {
+  RowRange all = {0, uint16_t(display->bounds.h)};
+  presentAsync(display, &all, 1);
+}
+
+void Presenter::presentAsync(PicoGraphics_PenP8* display,
+                             const RowRange* ranges, size_t count) {
+  // The scan-out buffer may still be being written by DMA
+  waitForDma();
+  for (size_t i = 0; i < count; i++) {
+    expand((const uint8_t*)display->frame_buffer, display->bounds.w,
+           display->bounds.h, ranges[i].first, ranges[i].last);
+  }
+}
+
+void Presenter::clearAsync(PicoGraphics_PenP8* display, uint8_t pen) {
+  RowRange all = {0, uint16_t(display->bounds.h)};
+  clearAsync(display, pen, &all, 1);
+}
+
+void Presenter::clearAsync(PicoGraphics_PenP8* display, uint8_t pen,
+                           const RowRange* ranges, size_t count) {
+  if (display->bounds.w % 2 != 0) {
+    // Rows are not a whole number of 16 bit transfers, so clear them here
+    // once the buffer is no longer being presented
+    waitForDma();
+    for (size_t i = 0; i < count; i++) {
+      uint16_t last = ranges[i].last > display->bounds.h ? display->bounds.h
+                                                         : ranges[i].last;
+      if (ranges[i].first >= last) continue;
+      memset((uint8_t*)display->frame_buffer +
+                 ranges[i].first * display->bounds.w,
+             pen, (last - ranges[i].first) * display->bounds.w);
+    }
+    return;
+  }
+  // Treat each pair of indices as one 16 bit pixel
+  uint32_t word = pen * 0x01010101u;
+  if (word != fillWord) waitForDma();
+  fillWord = word;
+  startDma((const uint16_t*)&fillWord, false,
+           (uint16_t*)display->frame_buffer, display->bounds.w / 2,
+           display->bounds.h, ranges, count);
+}
+
+void Presenter::startDma(const uint16_t* src, bool incrementSrc, uint16_t* dst,
+                         uint16_t width, uint16_t height,
+                         const RowRange* ranges, size_t count) {
+  if (count == 0) return;
+  claimChannels();
+
+  // Transfer words when both buffers allow it, as this halves the transfers
+  bool words = ((uintptr_t)src % 4 == 0) && ((uintptr_t)dst % 4 == 0) &&
+               (width % 2 == 0);
+  dma_channel_config cfg = dma_channel_get_default_config(copyChannel);
+  channel_config_set_transfer_data_size(&cfg,
+                                        words ? DMA_SIZE_32 : DMA_SIZE_16);
+  channel_config_set_read_increment(&cfg, incrementSrc);
+  channel_config_set_write_increment(&cfg, true);
+  channel_config_set_chain_to(&cfg, ctrlChannel);
+  uint32_t ctrl = channel_config_get_ctrl_value(&cfg);
+
+  // Build a block of alias 1 register values (ctrl, read address, write
+  // address, count + trigger) for each range
+  uint32_t newBlocks[MAX_DMA_RANGES * 4];
+  size_t blocks = 0;
+  for (size_t i = 0; i < count; i++) {
+    uint16_t first = ranges[i].first;
+    uint16_t last = ranges[i].last > height ? height : ranges[i].last;
+    if (first >= last) continue;
+    if (blocks == MAX_DMA_RANGES) {
+      // Out of blocks, so extend the last one to the end of this range
+      blocks--;
+      first = (newBlocks[blocks * 4 + 2] - (uintptr_t)dst) /
+              (width * sizeof(uint16_t));
+    }
+    uint32_t* block = newBlocks + blocks * 4;
+    uint32_t pixels = (last - first) * width;
+    block[0] = ctrl;
+    block[1] = (uintptr_t)(incrementSrc ? src + first * width : src);
+    block[2] = (uintptr_t)(dst + first * width);
+    block[3] = words ? pixels / 2 : pixels;
+    blocks++;
+  }
+  if (blocks == 0) return;
+
+  // Run after the transfers already queued, such as a clear straight after a
+  // present of the same buffer
+  if (dmaBusy() && appendBlocks(newBlocks, blocks)) return;
+  waitForDma();
+
+  memcpy(dmaBlocks, newBlocks, blocks * 4 * sizeof(uint32_t));
+  memset(dmaBlocks + blocks * 4, 0, 4 * sizeof(uint32_t));
+  dmaBlockCount = blocks;
+  dmaEnd = (uintptr_t)(dmaBlocks + (blocks + 1) * 4);
+
+  // The control channel writes each 4 word block into the copy channel
+  // registers, wrapping its write address every 16 bytes
+  dma_channel_config ctrlCfg = dma_channel_get_default_config(ctrlChannel);
+  channel_config_set_transfer_data_size(&ctrlCfg, DMA_SIZE_32);
+  channel_config_set_read_increment(&ctrlCfg, true);
+  channel_config_set_write_increment(&ctrlCfg, true);
+  channel_config_set_ring(&ctrlCfg, true, 4);
+  dma_channel_configure(ctrlChannel, &ctrlCfg,
+                        &dma_hw->ch[copyChannel].al1_ctrl, dmaBlocks, 4, true);
+}
+
+bool Presenter::appendBlocks(const uint32_t* blocks, size_t count) {
+  if (dmaBlockCount + count > MAX_CHAIN_BLOCKS) return false;
+
+  // The control channel stops at the null block, so everything after it can
+  // be written while the chain runs
+  uint32_t* tail = dmaBlocks + dmaBlockCount * 4;
+  memcpy(tail + 4, blocks + 4, (count - 1) * 4 * sizeof(uint32_t));
+  memset(tail + count * 4, 0, 4 * sizeof(uint32_t));
+
+  // The null block itself can only be replaced while the control channel is
+  // sure not to read it part way through. That is while it still has other
+  // blocks to read first, or the copy it is waiting on has a good way to go.
+  // Otherwise the chain is about to end, and is started again instead.
+  uint32_t irq = save_and_disable_interrupts();
+  uintptr_t next = dma_hw->ch[ctrlChannel].read_addr;
+  uint32_t remaining = dma_hw->ch[copyChannel].transfer_count & 0x0FFFFFFF;
+  bool safe = next < (uintptr_t)tail ||
+              (next == (uintptr_t)tail && remaining >= MIN_APPEND_TRANSFERS);
+  if (safe) {
+    tail[0] = blocks[0];
+    tail[1] = blocks[1];
+    tail[2] = blocks[2];
+    // The count triggers the copy, so it is the last word to change
+    __dmb();
+    tail[3] = blocks[3];
+    dmaBlockCount += count;
+    dmaEnd = (uintptr_t)(tail + (count + 1) * 4);
+  }
+  restore_interrupts(irq);
+  return safe;
+}
+
+bool Presenter::dmaBusy() {
+  if (dmaEnd == 0) return false;  // Nothing started yet
+  // Check the control channel has read the null block too, as neither channel
+  // is busy for an instant when the copy channel chains back to it
+  return dma_hw->ch[ctrlChannel].read_addr != dmaEnd ||
+         dma_channel_is_busy(ctrlChannel) || dma_channel_is_busy(copyChannel);
+}
+
+void Presenter::waitForDma() {
+  while (dmaBusy()) {
+    tight_loop_contents();
+  }
+}
+
+void Presenter::claimChannels() {
+  if (ctrlChannel >= 0) return;
+  ctrlChannel = dma_claim_unused_channel(true);
+  copyChannel = dma_claim_unused_channel(true);
+}
+
+void Presenter::expand(const uint8_t* src, uint16_t src_width,
+                       uint16_t src_height, uint16_t first_row,
+                       uint16_t last_row) {
+  if (last_row > src_height) last_row = src_height;
+  if (first_row >= last_row) return;
+
+  // Range of screen rows which show the source rows, as for upscale()
+  int first_y = (first_row * screen_height + src_height - 1) / src_height;
+  int last_y = (last_row * screen_height + src_height - 1) / src_height;
+
+  int lastSrcY = -1;
+  for (int y = first_y; y < last_y; ++y) {
+    int srcY = y * src_height / screen_height;
+    uint16_t* dst_row = screen_buffer + y * screen_width;
+    if (srcY == lastSrcY) {
+      memcpy(dst_row, dst_row - screen_width, screen_width * sizeof(uint16_t));
+    } else {
+      expandRow(src + srcY * src_width, dst_row, src_width);
+      lastSrcY = srcY;
+    }
+  }
+}
+
+void Presenter::expandRow(const uint8_t* src_row, uint16_t* dst_row,
+                          uint16_t src_width) {
+  const uint16_t* lut = paletteLUT;
+  if (src_width == screen_width && (uintptr_t)src_row % 4 == 0) {
+    // Look up four indices from each word read
+    const uint32_t* src32 = (const uint32_t*)src_row;
+    int x = 0;
+    for (; x + 4 <= screen_width; x += 4) {
+      uint32_t indices = *src32++;
+      dst_row[x] = lut[indices & 0xFF];
+      dst_row[x + 1] = lut[(indices >> 8) & 0xFF];
+      dst_row[x + 2] = lut[(indices >> 16) & 0xFF];
+      dst_row[x + 3] = lut[indices >> 24];
+    }
+    for (; x < screen_width; ++x) dst_row[x] = lut[src_row[x]];
+    return;
+  }
+  // Scale the row, stepping through the source in 16.16 fixed point
+  uint32_t step = ((uint32_t)src_width << 16) / screen_width;
+  uint32_t pos = 0;
+  for (int x = 0; x < screen_width; ++x, pos += step) {
+    dst_row[x] = lut[src_row[pos >> 16]];
+  }
+}
+
+void Presenter::upscaleRow(const uint16_t* src_row, uint16_t* dst_row,
+                           uint32_t step) {
+  interp0->accum[0] = 0;
+  interp0->base[0] = step;
+  interp0->base[2] = (uintptr_t)src_row;
+  for (int x = 0; x < screen_width; ++x) {
+    dst_row[x] = *(uint16_t*)(uintptr_t)interp0->pop[2];
+  }
+}
@@ -0,0 +1,109 @@
+/*
+ * Presents a drawing buffer onto the Presto scan-out buffer. The drawing
+ * buffer does not need to match the resolution of the scan-out buffer. A
+ * smaller buffer (e.g. 240 x 240) is upscaled during the copy, using the
+ * RP2350 hardware interpolator to generate the source pixel addresses. This
+ * allows square pixels to be drawn into a quarter of the memory of a full
+ * resolution buffer.
+ *
+ * A drawing buffer matching the scan-out buffer can also be presented
+ * asynchronously by DMA, and drawing buffers can be cleared by DMA. These run
+ * in the background while the next frame is prepared, and waitForDma() must be
+ * called before drawing into the buffer again. A clear started while a present
+ * is still running is queued behind it, so neither call waits for the DMA.
+ *
+ * An 8 bit palette drawing buffer is expanded into RGB565 through a lookup
+ * table made from its palette by setPalette(). The expansion is done by the
+ * CPU, so these buffers are presented before presentAsync() returns.
+ *
+ * Copyright (c) 2025 Dr Footleg
+ *
+ * License: GNU GPL v3.0
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "libraries/pico_graphics/pico_graphics.hpp"
+
+using namespace pimoroni;
+
+// A range of rows from first up to but not including last
+struct RowRange {
+  uint16_t first;
+  uint16_t last;
+};
+
+class Presenter {
+ public:
+  Presenter(uint16_t* screen_buffer, uint16_t screen_width,
+            uint16_t screen_height);
+  void upscale(const uint16_t* src, uint16_t src_width, uint16_t src_height);
+  void upscale(PicoGraphics_PenRGB565* display);
+  // Present only source rows first_row to last_row - 1
+  void upscale(const uint16_t* src, uint16_t src_width, uint16_t src_height,
+               uint16_t first_row, uint16_t last_row);
+  void upscale(PicoGraphics_PenRGB565* display, uint16_t first_row,
+               uint16_t last_row);
+
+  // Start copying the drawing buffer (or just the listed rows of it) to the
+  // scan-out buffer by DMA and return straight away. Buffers which need
+  // upscaling are presented before returning, as DMA cannot scale them.
+  void presentAsync(PicoGraphics_PenRGB565* display);
+  void presentAsync(PicoGraphics_PenRGB565* display, const RowRange* ranges,
+                    size_t count);
+
+  // Start filling the drawing buffer (or just the listed rows of it) with a
+  // pen colour by DMA and return straight away
+  void clearAsync(PicoGraphics_PenRGB565* display, uint16_t pen);
+  void clearAsync(PicoGraphics_PenRGB565* display, uint16_t pen,
+                  const RowRange* ranges, size_t count);
+
+  // Palette drawing buffers. Call setPalette() again after changing pens.
+  void setPalette(PicoGraphics_PenP8* display);
+  void presentAsync(PicoGraphics_PenP8* display);
+  void presentAsync(PicoGraphics_PenP8* display, const RowRange* ranges,
+                    size_t count);
+  void clearAsync(PicoGraphics_PenP8* display, uint8_t pen);
+  void clearAsync(PicoGraphics_PenP8* display, uint8_t pen,
+                  const RowRange* ranges, size_t count);
+
+  // Fence for the asynchronous present and clear
+  bool dmaBusy();
+  void waitForDma();
+
+ private:
+  // Max row ranges transferred in one go. Further ranges are merged.
+  static const size_t MAX_DMA_RANGES = 32;
+  // Max blocks in a chain, enough for a present followed by a clear
+  static const size_t MAX_CHAIN_BLOCKS = MAX_DMA_RANGES * 2;
+  // Transfers the running copy must have left for blocks to be added to the
+  // end of the chain, rather than waiting for it to end
+  static const uint32_t MIN_APPEND_TRANSFERS = 64;
+
+  uint16_t* screen_buffer;
+  uint16_t screen_width;
+  uint16_t screen_height;
+
+  // DMA channels for the asynchronous present and clear. The control channel
+  // loads each block of register values into the copy channel, which chains
+  // back to it when done. A null block ends the chain.
+  int ctrlChannel = -1;
+  int copyChannel = -1;
+  uint32_t dmaBlocks[(MAX_CHAIN_BLOCKS + 1) * 4];
+  size_t dmaBlockCount = 0;  // Blocks in the chain before the null block
+  uintptr_t dmaEnd = 0;  // Control read address once the null block is read
+  // Pen repeated in both halves, the source for clears
+  uint32_t fillWord = 0;
+  uint16_t paletteLUT[PicoGraphics_PenP8::palette_size];  // RGB565 pens
+  void claimChannels();
+  void startDma(const uint16_t* src, bool incrementSrc, uint16_t* dst,
+                uint16_t width, uint16_t height, const RowRange* ranges,
+                size_t count);
+  bool appendBlocks(const uint32_t* blocks, size_t count);
+  void upscaleRow(const uint16_t* src_row, uint16_t* dst_row, uint32_t step);
+  void expand(const uint8_t* src, uint16_t src_width, uint16_t src_height,
+              uint16_t first_row, uint16_t last_row);
+  void expandRow(const uint8_t* src_row, uint16_t* dst_row, uint16_t src_width);
+};
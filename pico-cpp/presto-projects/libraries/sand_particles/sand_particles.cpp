@@ -0,0 +1,145 @@
+/*
+ * Gravity driven particles, stored compactly and colliding through a bitmap
+ * of the grid cells they fill.
+ *
+ * Copyright (c) 2025 Dr Footleg
+ *
+ * License: GNU GPL v3.0
+ */
+#include "sand_particles.hpp"
+
+#include <math.h>
+#include <stdlib.h>
+
+SandParticles::SandParticles(uint16_t width, uint16_t height, uint16_t shake,
+                             uint8_t bounce)
+    : shake(shake), bounce(bounce) {
+  resize(width, height);
+}
+
+void SandParticles::resize(uint16_t width, uint16_t height) {
+  this->width = width;
+  this->height = height;
+  uint32_t cells = width * height;
+  posX.reserve(cells);
+  posY.reserve(cells);
+  velX.reserve(cells);
+  velY.reserve(cells);
+  colour.reserve(cells);
+  occupied.assign((cells + 31) / 32, 0);
+  clear();
+}
+
+void SandParticles::clear() {
+  posX.clear();
+  posY.clear();
+  velX.clear();
+  velY.clear();
+  colour.clear();
+  occupied.assign(occupied.size(), 0);
+}
+
+bool SandParticles::addParticle(uint16_t x, uint16_t y, uint16_t rgb565) {
+  uint32_t cell = y * width + x;
+  if (x >= width || y >= height || isOccupied(cell)) return false;
+  setOccupied(cell);
+  posX.push_back(x * 256 + 128);
+  posY.push_back(y * 256 + 128);
+  velX.push_back(0);
+  velY.push_back(0);
+  colour.push_back(rgb565);
+  return true;
+}
+
+void SandParticles::setAcceleration(int16_t ax, int16_t ay) {
+  accelX = ax;
+  accelY = ay;
+}
+
+int16_t SandParticles::randomShake() {
+  // Xorshift, as rand() is far too slow to call for every particle
+  randomState ^= randomState << 13;
+  randomState ^= randomState >> 17;
+  randomState ^= randomState << 5;
+  return int32_t(randomState % (2 * shake + 1)) - shake;
+}
+
+void SandParticles::step(CellCallback setCell, void* context) {
+  int32_t maxX = width * 256 - 1;
+  int32_t maxY = height * 256 - 1;
+  int16_t ax = accelX >> ACCEL_SHIFT;
+  int16_t ay = accelY >> ACCEL_SHIFT;
+  uint32_t count = colour.size();
+
+  for (uint32_t i = 0; i < count; i++) {
+    // Accelerate, with a little random shake, up to the speed limit
+    int32_t vx = velX[i] + ax + (shake ? randomShake() >> ACCEL_SHIFT : 0);
+    int32_t vy = velY[i] + ay + (shake ? randomShake() >> ACCEL_SHIFT : 0);
+    int32_t speed2 = vx * vx + vy * vy;
+    if (speed2 > MAX_SPEED * MAX_SPEED) {
+      // Scale back to the limit. Float is only needed for the few particles
+      // going too fast.
+      float scale = MAX_SPEED / sqrtf(float(speed2));
+      vx = int32_t(vx * scale);
+      vy = int32_t(vy * scale);
+    }
+
+    // Move, bouncing off the edges of the grid
+    int32_t x = posX[i];
+    int32_t y = posY[i];
+    int32_t newX = x + vx;
+    int32_t newY = y + vy;
+    if (newX < 0) {
+      newX = 0;
+      vx = rebound(vx);
+    } else if (newX > maxX) {
+      newX = maxX;
+      vx = rebound(vx);
+    }
+    if (newY < 0) {
+      newY = 0;
+      vy = rebound(vy);
+    } else if (newY > maxY) {
+      newY = maxY;
+      vy = rebound(vy);
+    }
+
+    uint32_t oldCell = (y >> 8) * width + (x >> 8);
+    uint32_t newCell = (newY >> 8) * width + (newX >> 8);
+    if (newCell != oldCell && isOccupied(newCell)) {
+      // Blocked. Slide along whichever axis is free, favouring the faster
+      // one, or stop and bounce on both if neither is.
+      uint32_t cellX = (y >> 8) * width + (newX >> 8);  // Move across only
+      uint32_t cellY = (newY >> 8) * width + (x >> 8);  // Move down only
+      bool freeX = cellX == oldCell || !isOccupied(cellX);
+      bool freeY = cellY == oldCell || !isOccupied(cellY);
+      bool fasterX = abs(vx) >= abs(vy);
+      if (freeX && (fasterX || !freeY)) {
+        newY = y;
+        vy = rebound(vy);
+        newCell = cellX;
+      } else if (freeY) {
+        newX = x;
+        vx = rebound(vx);
+        newCell = cellY;
+      } else {
+        newX = x;
+        newY = y;
+        vx = rebound(vx);
+        vy = rebound(vy);
+        newCell = oldCell;
+      }
+    }
+
+    posX[i] = newX;
+    posY[i] = newY;
+    velX[i] = vx;
+    velY[i] = vy;
+    if (newCell != oldCell) {
+      clearOccupied(oldCell);
+      setOccupied(newCell);
+      setCell(context, x >> 8, y >> 8, 0);
+      setCell(context, newX >> 8, newY >> 8, colour[i]);
+    }
+  }
+}
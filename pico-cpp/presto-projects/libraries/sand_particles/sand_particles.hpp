@@ -0,0 +1,76 @@
+/*
+ * Gravity driven particles for very large numbers of particles, such as a
+ * whole screen full of cells turned to sand. Each particle is kept in a few
+ * bytes, with its position and velocity held in fixed point (1/256ths of a
+ * cell) in separate arrays. Which grid cells are taken is kept in a bitmap of
+ * one bit per cell, so a particle checks whether it can move into a cell
+ * with a single lookup rather than by searching the other particles.
+ *
+ * Copyright (c) 2025 Dr Footleg
+ *
+ * License: GNU GPL v3.0
+ */
+#pragma once
+
+#include <stdint.h>
+
+#include <vector>
+
+class SandParticles {
+ public:
+  // Called for each grid cell which changes, with the colour of the particle
+  // now in it, or 0 if the cell is empty
+  typedef void (*CellCallback)(void* context, uint16_t x, uint16_t y,
+                               uint16_t colour);
+
+  // The grid can be up to 255 cells in each direction. Shake is the most
+  // random acceleration added to each particle each step, and bounce is how
+  // much speed (out of 256) a particle keeps when it hits something.
+  SandParticles(uint16_t width, uint16_t height, uint16_t shake,
+                uint8_t bounce);
+
+  void clear();
+  // Change the grid size, removing all the particles. The storage is kept,
+  // so it is only reallocated for a larger grid.
+  void resize(uint16_t width, uint16_t height);
+  // Add a particle with an RGB565 colour, if the cell is free
+  bool addParticle(uint16_t x, uint16_t y, uint16_t colour);
+  uint32_t getCount() { return colour.size(); }
+
+  // Acceleration on the same scale as GravityParticles
+  void setAcceleration(int16_t ax, int16_t ay);
+
+  // Move every particle one step, reporting the cells which changed
+  void step(CellCallback setCell, void* context);
+
+ private:
+  static const int MAX_SPEED = 256;  // One cell per step
+  static const int ACCEL_SHIFT = 3;  // Acceleration is applied at 1/8 scale
+
+  uint16_t width;
+  uint16_t height;
+  uint16_t shake;
+  uint8_t bounce;
+  int16_t accelX = 0;
+  int16_t accelY = 0;
+  uint32_t randomState = 0x12345678;
+
+  // One entry per particle in each array
+  std::vector<uint16_t> posX;  // Position in 1/256ths of a cell
+  std::vector<uint16_t> posY;
+  std::vector<int16_t> velX;  // Speed in 1/256ths of a cell per step
+  std::vector<int16_t> velY;
+  std::vector<uint16_t> colour;
+
+  std::vector<uint32_t> occupied;  // One bit per grid cell
+
+  bool isOccupied(uint32_t cell) {
+    return (occupied[cell >> 5] >> (cell & 31)) & 1;
+  }
+  void setOccupied(uint32_t cell) { occupied[cell >> 5] |= 1u << (cell & 31); }
+  void clearOccupied(uint32_t cell) {
+    occupied[cell >> 5] &= ~(1u << (cell & 31));
+  }
+  int16_t randomShake();
+  int16_t rebound(int16_t speed) { return -speed * bounce / 256; }
+};
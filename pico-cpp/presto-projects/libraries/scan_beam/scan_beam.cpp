@@ -0,0 +1,58 @@
+/*
+ * Tracks which row of the scan-out buffer the Presto display is reading, so
+ * that a program drawing straight into the scan-out buffer can avoid writing
+ * to rows just as they are sent to the screen.
+ *
+ * Copyright (c) 2025 Dr Footleg
+ *
+ * License: GNU GPL v3.0
+ */
+#include "scan_beam.hpp"
+
+#include "hardware/dma.h"
+
+ScanBeam::ScanBeam(const uint16_t* screen_buffer, uint16_t width,
+                   uint16_t height)
+    : screen_buffer(screen_buffer), width(width), height(height) {};
+
+bool ScanBeam::readsBuffer(int ch) {
+  uintptr_t addr = dma_hw->ch[ch].read_addr;
+  uintptr_t start = (uintptr_t)screen_buffer;
+  return addr >= start && addr <= start + width * height * sizeof(uint16_t);
+}
+
+int ScanBeam::row() {
+  if (channel < 0 || !readsBuffer(channel)) {
+    // Look for the channel the display driver claimed to stream the buffer
+    channel = -1;
+    for (int ch = 0; ch < NUM_DMA_CHANNELS; ch++) {
+      if (dma_channel_is_claimed(ch) && readsBuffer(ch)) {
+        channel = ch;
+        break;
+      }
+    }
+    if (channel < 0) return -1;
+  }
+  uintptr_t offset = dma_hw->ch[channel].read_addr - (uintptr_t)screen_buffer;
+  return offset / (width * sizeof(uint16_t));
+}
+
+bool ScanBeam::passed(int y) {
+  int beam = row();
+  if (beam < 0 || beam >= height) return true;
+  return beam - BEHIND_ROWS >= y;
+}
+
+bool ScanBeam::clear(int y1, int y2, int ahead) {
+  int beam = row();
+  if (beam < 0) return true;  // Nothing to avoid
+  int first = beam - BEHIND_ROWS;
+  int last = beam + ahead;
+  if (y2 >= first && y1 <= last) return false;
+  // Rows past the bottom are read again from the top of the next frame
+  if (last >= height && y1 <= last - height) return false;
+  // Rows behind the beam at the top may still be queued from the bottom rows
+  // of the last frame
+  if (first < 0 && y2 >= first + height) return false;
+  return true;
+}
@@ -0,0 +1,43 @@
+/*
+ * Tracks which row of the scan-out buffer the Presto display is reading, so
+ * that a program drawing straight into the scan-out buffer can avoid writing
+ * to rows just as they are sent to the screen. The ST7701 driver streams the
+ * buffer out a row at a time by DMA, so the row being read is found from the
+ * read address of the DMA channel doing this.
+ *
+ * Copyright (c) 2025 Dr Footleg
+ *
+ * License: GNU GPL v3.0
+ */
+#pragma once
+
+#include <stdint.h>
+
+class ScanBeam {
+ public:
+  ScanBeam(const uint16_t* screen_buffer, uint16_t width, uint16_t height);
+
+  // Row of the scan-out buffer being read by the display. Returns height
+  // after the last row has been read, or -1 if the scan-out DMA channel
+  // cannot be found.
+  int row();
+
+  // Whether rows y1 to y2 are clear of the rows the display is reading now
+  // and the next ahead rows after it (wrapping round to the top), so they
+  // can be written without tearing
+  bool clear(int y1, int y2, int ahead);
+
+  // Whether the display has finished reading the rows above y in the frame
+  // it is sending now. Always true if the beam cannot be found.
+  bool passed(int y);
+
+ private:
+  // Rows just behind the beam may still be queued up in the display FIFO
+  static const int BEHIND_ROWS = 2;
+
+  const uint16_t* screen_buffer;
+  uint16_t width;
+  uint16_t height;
+  int channel = -1;  // DMA channel found reading the scan-out buffer
+  bool readsBuffer(int ch);
+};
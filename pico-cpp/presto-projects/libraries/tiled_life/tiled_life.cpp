@@ -0,0 +1,213 @@
+/*
+ * A Game of Life world split into tiles, stepping only the tiles where
+ * something is happening.
+ *
+ * Copyright (c) 2025 Dr Footleg
+ *
+ * License: GNU GPL v3.0
+ */
+#include "tiled_life.hpp"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "../bit_life/bit_life.hpp"
+
+TiledLife::TiledLife(uint16_t tilesWide, uint16_t tilesHigh)
+    : tilesWide(tilesWide), tilesHigh(tilesHigh) {
+  uint32_t count = tilesWide * tilesHigh;
+  tiles.assign(count, nullptr);
+  active.assign((count + 31) / 32, 0);
+  nextActive.assign(active.size(), 0);
+  dirty.assign(active.size(), 0);
+  stepped.reserve(count);
+}
+
+TiledLife::~TiledLife() {
+  for (Tile* tile : tiles) free(tile);
+  for (Tile* tile : spareTiles) free(tile);
+}
+
+void TiledLife::reserveTiles(uint32_t count) {
+  spareTiles.reserve(count);
+  while (spareTiles.size() < count) {
+    Tile* tile = (Tile*)calloc(1, sizeof(Tile));
+    if (!tile) break;
+    spareTiles.push_back(tile);
+  }
+}
+
+void TiledLife::clear() {
+  for (Tile* tile : tiles) {
+    if (tile) memset(tile, 0, sizeof(Tile));
+  }
+  active.assign(active.size(), 0);
+  dirty.assign(dirty.size(), 0);
+  generation = 0;
+}
+
+TiledLife::Tile* TiledLife::allocateTile(uint32_t index) {
+  Tile* tile = (Tile*)calloc(1, sizeof(Tile));
+  if (tile) {
+    tiles[index] = tile;
+    allocatedTiles++;
+  }
+  return tile;
+}
+
+void TiledLife::setCell(uint32_t x, uint32_t y, bool alive) {
+  if (x >= getWidth() || y >= getHeight()) return;
+  uint16_t tx = x / TILE_SIZE;
+  uint16_t ty = y / TILE_SIZE;
+  uint32_t index = ty * tilesWide + tx;
+  Tile* tile = tiles[index];
+  if (!tile) {
+    if (!alive) return;
+    tile = allocateTile(index);
+    if (!tile) return;
+  }
+  uint32_t& word = tile->cells[tile->front][(y % TILE_SIZE) * TILE_WORDS +
+                                            (x % TILE_SIZE) / 32];
+  uint32_t bit = 1u << (x & 31);
+  word = alive ? word | bit : word & ~bit;
+
+  // Step this tile and those around it next generation
+  for (int dy = -1; dy <= 1; dy++) {
+    for (int dx = -1; dx <= 1; dx++) {
+      int nx = tx + dx;
+      int ny = ty + dy;
+      if (nx >= 0 && ny >= 0 && nx < tilesWide && ny < tilesHigh) {
+        setBit(active, ny * tilesWide + nx);
+      }
+    }
+  }
+}
+
+bool TiledLife::getCell(uint32_t x, uint32_t y) {
+  if (x >= getWidth() || y >= getHeight()) return false;
+  const uint32_t* row = tileRow(x / TILE_SIZE, y / TILE_SIZE, y % TILE_SIZE);
+  return row && (row[(x % TILE_SIZE) / 32] >> (x & 31)) & 1;
+}
+
+const uint32_t* TiledLife::tileRow(uint16_t tx, uint16_t ty, uint16_t row) {
+  Tile* tile = tiles[ty * tilesWide + tx];
+  return tile ? &tile->cells[tile->front][row * TILE_WORDS] : nullptr;
+}
+
+const uint32_t* TiledLife::frontRow(int tx, int ty, int row) {
+  if (tx < 0 || ty < 0 || tx >= tilesWide || ty >= tilesHigh) return nullptr;
+  return tileRow(tx, ty, row);
+}
+
+void TiledLife::activate(int tx, int ty) {
+  if (tx >= 0 && ty >= 0 && tx < tilesWide && ty < tilesHigh) {
+    setBit(nextActive, ty * tilesWide + tx);
+  }
+}
+
+uint32_t TiledLife::step() {
+  nextActive.assign(nextActive.size(), 0);
+  dirty.assign(dirty.size(), 0);
+  stepped.clear();
+
+  // Work out the next generation of every active tile into its back buffer,
+  // leaving the current generation in place for its neighbours to read
+  for (uint32_t w = 0; w < active.size(); w++) {
+    for (uint32_t bits = active[w]; bits; bits &= bits - 1) {
+      uint32_t index = w * 32 + __builtin_ctz(bits);
+      stepTile(index % tilesWide, index / tilesWide);
+    }
+  }
+
+  // Then make the new generation current
+  for (uint16_t index : stepped) tiles[index]->front ^= 1;
+  active.swap(nextActive);
+  generation++;
+  return stepped.size();
+}
+
+void TiledLife::stepTile(uint16_t tx, uint16_t ty) {
+  // Copy the tile with a border of the cells around it from its neighbours
+  uint32_t padded[TILE_SIZE + 2][TILE_WORDS + 2];
+  for (int r = -1; r <= TILE_SIZE; r++) {
+    int y = ty;
+    int row = r;
+    if (r < 0) {
+      y--;
+      row = TILE_SIZE - 1;
+    } else if (r == TILE_SIZE) {
+      y++;
+      row = 0;
+    }
+    const uint32_t* west = frontRow(tx - 1, y, row);
+    const uint32_t* centre = frontRow(tx, y, row);
+    const uint32_t* east = frontRow(tx + 1, y, row);
+    uint32_t* line = padded[r + 1];
+    line[0] = west ? west[TILE_WORDS - 1] : 0;
+    for (int i = 0; i < TILE_WORDS; i++) line[i + 1] = centre ? centre[i] : 0;
+    line[TILE_WORDS + 1] = east ? east[0] : 0;
+  }
+
+  uint32_t next[TILE_SIZE * TILE_WORDS];
+  uint32_t changed = 0;
+  uint32_t westChanged = 0;  // Changes in the first and last columns
+  uint32_t eastChanged = 0;
+  for (int r = 0; r < TILE_SIZE; r++) {
+    for (int i = 0; i < TILE_WORDS; i++) {
+      uint32_t west[3], row[3], east[3];
+      for (int j = 0; j < 3; j++) {
+        const uint32_t* line = padded[r + j];
+        row[j] = line[i + 1];
+        west[j] = line[i + 1] << 1 | line[i] >> 31;
+        east[j] = line[i + 1] >> 1 | line[i + 2] << 31;
+      }
+      uint32_t cells = BitLife::nextCells(west, row, east);
+      next[r * TILE_WORDS + i] = cells;
+      changed |= cells ^ row[1];
+    }
+    westChanged |= (next[r * TILE_WORDS] ^ padded[r + 1][1]) & 1;
+    eastChanged |= (next[r * TILE_WORDS + TILE_WORDS - 1] ^
+                    padded[r + 1][TILE_WORDS]) >> 31;
+  }
+
+  // Nothing changed, so the tile stays as it is and can rest until one of its
+  // neighbours changes along their shared edge
+  if (!changed) return;
+
+  uint32_t index = ty * tilesWide + tx;
+  Tile* tile = tiles[index];
+  if (!tile) {
+    if (spareTiles.empty()) return;
+    tile = spareTiles.back();
+    spareTiles.pop_back();
+    tiles[index] = tile;
+    allocatedTiles++;
+  }
+  memcpy(tile->cells[tile->front ^ 1], next, sizeof(next));
+  stepped.push_back(index);
+  setBit(dirty, index);
+
+  // Step this tile again next generation, along with the neighbours on the
+  // edges and corners where cells changed
+  uint32_t north = 0;
+  uint32_t south = 0;
+  const uint32_t* lastRow = &next[(TILE_SIZE - 1) * TILE_WORDS];
+  for (int i = 0; i < TILE_WORDS; i++) {
+    north |= next[i] ^ padded[1][i + 1];
+    south |= lastRow[i] ^ padded[TILE_SIZE][i + 1];
+  }
+  const int lastWord = TILE_WORDS - 1;
+  bool northWest = (next[0] ^ padded[1][1]) & 1;
+  bool northEast = (next[lastWord] ^ padded[1][lastWord + 1]) >> 31;
+  bool southWest = (lastRow[0] ^ padded[TILE_SIZE][1]) & 1;
+  bool southEast = (lastRow[lastWord] ^ padded[TILE_SIZE][lastWord + 1]) >> 31;
+  activate(tx, ty);
+  if (north) activate(tx, ty - 1);
+  if (south) activate(tx, ty + 1);
+  if (westChanged) activate(tx - 1, ty);
+  if (eastChanged) activate(tx + 1, ty);
+  if (northWest) activate(tx - 1, ty - 1);
+  if (northEast) activate(tx + 1, ty - 1);
+  if (southWest) activate(tx - 1, ty + 1);
+  if (southEast) activate(tx + 1, ty + 1);
+}
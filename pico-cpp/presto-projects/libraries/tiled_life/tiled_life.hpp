@@ -0,0 +1,92 @@
+/*
+ * A Game of Life world much larger than the screen, split into square tiles
+ * of bit packed cells. Tiles are only allocated once cells come to life in
+ * them, so a mostly empty world takes little memory, and with malloc set up
+ * to use PSRAM the world can run to millions of cells. Each generation only
+ * steps the tiles which changed in the last generation and their neighbours
+ * along the edges that changed, so the time taken depends on how much is
+ * happening rather than on the size of the world. Cells beyond the edges of
+ * the world are always dead.
+ *
+ * Copyright (c) 2025 Dr Footleg
+ *
+ * License: GNU GPL v3.0
+ */
+#pragma once
+
+#include <stdint.h>
+
+#include <vector>
+
+class TiledLife {
+ public:
+  static const uint16_t TILE_SIZE = 64;  // Cells along each side of a tile
+  static const uint16_t TILE_WORDS = TILE_SIZE / 32;  // Words in a tile row
+
+  TiledLife(uint16_t tilesWide, uint16_t tilesHigh);
+  ~TiledLife();
+
+  uint32_t getWidth() { return tilesWide * TILE_SIZE; }
+  uint32_t getHeight() { return tilesHigh * TILE_SIZE; }
+  uint16_t getTilesWide() { return tilesWide; }
+  uint16_t getTilesHigh() { return tilesHigh; }
+
+  // Kill every cell, keeping the tiles allocated for reuse
+  void clear();
+  void setCell(uint32_t x, uint32_t y, bool alive);
+  bool getCell(uint32_t x, uint32_t y);
+
+  // Calculate the next generation (B3/S23). Returns the number of tiles
+  // which were stepped. Tiles which come to life are taken from those set
+  // aside by reserveTiles, so this never calls malloc and can run on one core
+  // while the other allocates. Cells born into a new tile once those run out
+  // are lost.
+  uint32_t step();
+
+  // Set aside empty tiles for the next step to use, topping them up to count
+  void reserveTiles(uint32_t count);
+
+  // Whether any cells in a tile changed in the last step
+  bool tileChanged(uint16_t tx, uint16_t ty) {
+    return testBit(dirty, ty * tilesWide + tx);
+  }
+  // Row of cells in a tile, 32 cells to a word. Returns nullptr for tiles
+  // which have never had any live cells.
+  const uint32_t* tileRow(uint16_t tx, uint16_t ty, uint16_t row);
+
+  uint32_t getGeneration() { return generation; }
+  uint32_t getAllocatedTiles() { return allocatedTiles; }
+
+ private:
+  struct Tile {
+    // Current and next generations, swapped after each step
+    uint32_t cells[2][TILE_SIZE * TILE_WORDS];
+    uint8_t front;
+  };
+
+  uint16_t tilesWide;
+  uint16_t tilesHigh;
+  uint32_t generation = 0;
+  uint32_t allocatedTiles = 0;
+  std::vector<Tile*> tiles;  // nullptr until a tile first has live cells
+  // One bit per tile: tiles to step in the next generation, and tiles which
+  // changed in the last one
+  std::vector<uint32_t> active;
+  std::vector<uint32_t> nextActive;
+  std::vector<uint32_t> dirty;
+  std::vector<uint16_t> stepped;  // Tiles stepped in this generation
+  std::vector<Tile*> spareTiles;  // Set aside for step
+
+  static bool testBit(const std::vector<uint32_t>& bits, uint32_t i) {
+    return (bits[i >> 5] >> (i & 31)) & 1;
+  }
+  static void setBit(std::vector<uint32_t>& bits, uint32_t i) {
+    bits[i >> 5] |= 1u << (i & 31);
+  }
+
+  Tile* allocateTile(uint32_t index);
+  const uint32_t* frontRow(int tx, int ty, int row);
+  // Mark a tile to be stepped next generation, if it is inside the world
+  void activate(int tx, int ty);
+  void stepTile(uint16_t tx, uint16_t ty);
+};
@@ -0,0 +1,70 @@
+/*
+ * Polled sampling of the accelerometer, rotated into the screen plane.
+ *
+ * Copyright (c) 2025 Dr Footleg
+ *
+ * License: GNU GPL v3.0
+ */
+#include "tilt_sampler.hpp"
+
+#include <math.h>
+
+#include "../../drivers/lsm6ds3/lsm6ds3.hpp"
+#include "pico/time.h"
+
+TiltSampler::TiltSampler(LSM6DS3* imu, float screenAngle, int16_t reading1G,
+                         int16_t scale1G)
+    : imu(imu) {
+  factorX = cosf(screenAngle) * scale1G / reading1G;
+  factorY = float(scale1G) / reading1G;
+  factorZ = sinf(screenAngle) * scale1G / reading1G;
+}
+
+bool TiltSampler::start(uint32_t periodUs_) {
+  // Without a sensor stick on the Qw/ST port the reads would just fail, so
+  // there is nothing to sample
+  if (!imu->isConnected()) return false;
+  periodUs = periodUs_;
+  nextSampleUs = time_us_64();
+  running = true;
+  return true;
+}
+
+void TiltSampler::stop() { running = false; }
+
+void TiltSampler::poll() {
+  if (!running) return;
+  uint64_t now = time_us_64();
+  if (now < nextSampleUs) return;
+  // Time each sample from when the last one was due, so the rate does not
+  // drift with how often this is polled. Samples missed while the core was
+  // busy are skipped rather than taken in a burst.
+  nextSampleUs += periodUs;
+  if (nextSampleUs <= now) nextSampleUs = now + periodUs;
+  sample();
+}
+
+bool TiltSampler::getAcceleration(int16_t& x, int16_t& y) {
+  if (samples == 0) return false;
+  uint32_t packed = latest;
+  x = int16_t(packed & 0xFFFF);
+  y = int16_t(packed >> 16);
+  return true;
+}
+
+void TiltSampler::sample() {
+  // A failed read keeps the last sample (or none, so that the default
+  // gravity stays in effect)
+  LSM6DS3::SensorData data;
+  if (!imu->getReadings(data)) return;
+
+  // Rotate about the sensor Y axis into the plane of the screen. Sensor X
+  // then points up the screen and sensor Y to the left.
+  float up = data.ax * factorX + data.az * factorZ;
+  float left = data.ay * factorY;
+  int16_t x = int16_t(-left);
+  int16_t y = int16_t(-up);
+
+  latest = uint16_t(x) | uint32_t(uint16_t(y)) << 16;
+  samples = samples + 1;
+}
@@ -0,0 +1,55 @@
+/*
+ * Samples the LSM6DS3 accelerometer at the data rate of the sensor, whenever
+ * it is polled by a core with time to spare, and keeps the latest reading
+ * rotated into the plane of the screen. Reading the acceleration just picks up
+ * the last sample, so it never waits on the I2C bus.
+ *
+ * Copyright (c) 2025 Dr Footleg
+ *
+ * License: GNU GPL v3.0
+ */
+#pragma once
+
+#include <stdint.h>
+
+class LSM6DS3;
+
+class TiltSampler {
+ public:
+  // The screen is tilted back from the sensor by screenAngle (in radians)
+  // about the sensor Y axis. A sensor reading of reading1G is reported as an
+  // acceleration of scale1G.
+  TiltSampler(LSM6DS3* imu, float screenAngle, int16_t reading1G,
+              int16_t scale1G);
+
+  // Sample every periodUs from now on, when polled. Returns false, and never
+  // samples, if the sensor is not connected.
+  bool start(uint32_t periodUs);
+  void stop();
+
+  // Take a sample if one is due. This waits for the I2C read, so call it
+  // from a core which is not drawing, and only ever from the one core.
+  void poll();
+
+  // Latest acceleration across the screen, with x to the right and y down.
+  // Returns false until the first sample has been read from the sensor.
+  bool getAcceleration(int16_t& x, int16_t& y);
+
+  uint32_t getSampleCount() { return samples; }
+
+ private:
+  LSM6DS3* imu;
+  // Scale from each sensor axis reading to acceleration in the screen plane
+  float factorX;
+  float factorY;
+  float factorZ;
+  uint32_t periodUs;
+  uint64_t nextSampleUs;  // Time the next sample is due
+  bool running = false;
+  // Both axes are packed into one word, so a reader on either core never
+  // sees x from one sample with y from another
+  volatile uint32_t latest = 0;
+  volatile uint32_t samples = 0;
+
+  void sample();
+};
@@ -0,0 +1,73 @@
+/*
+ * Fades an RGB565 frame buffer towards black, two pixels at a time.
+ *
+ * Copyright (c) 2025 Dr Footleg
+ *
+ * License: GNU GPL v3.0
+ */
+#include "trail_fader.hpp"
+
+#include "pico/multicore.h"
+
+// The fader core 1 runs fades for
+static TrailFader* core1Fader = nullptr;
+
+TrailFader::TrailFader(PicoGraphics_PenRGB565* display, uint16_t* buffer)
+    : buffer(buffer), width(display->bounds.w), height(display->bounds.h) {
+  // Pico Graphics may store RGB565 pens byte swapped for the display
+  penSwapped = display->create_pen(255, 0, 0) != 0xF800;
+};
+
+void TrailFader::launchCore1() {
+  core1Fader = this;
+  multicore_launch_core1(core1Worker);
+  onCore1 = true;
+}
+
+void TrailFader::core1Worker() {
+  while (true) {
+    multicore_fifo_pop_blocking();
+    core1Fader->fade();
+    multicore_fifo_push_blocking(1);
+  }
+}
+
+void TrailFader::startFade() {
+  if (onCore1) {
+    waitForFade();
+    multicore_fifo_push_blocking(1);
+    fading = true;
+  } else {
+    fade();
+  }
+}
+
+void TrailFader::waitForFade() {
+  if (fading) {
+    multicore_fifo_pop_blocking();
+    fading = false;
+  }
+}
+
+void TrailFader::fade() { fadePixels(buffer, width * height, penSwapped); }
+
+void TrailFader::fadePixels(uint16_t* pixels, uint32_t count, bool swapped) {
+  uint32_t* words = (uint32_t*)pixels;
+  for (uint32_t i = 0; i < count / 2; i++) {
+    uint32_t w = words[i];
+    // Most of a trails frame has faded out already
+    if (w == 0) continue;
+    // Swap the bytes of both pixels back to RGB565
+    if (swapped) w = (w & 0x00FF00FF) << 8 | (w >> 8 & 0x00FF00FF);
+    // All ones in each pixel with the core flag set
+    uint32_t keep = (w & 0x00010001) * 0xFFFF;
+    // Each colour field becomes half plus a quarter of itself. The masks drop
+    // the bits shifted in from the field above, so no field can borrow from
+    // or carry into its neighbour. Faded pixels never gain the core flag.
+    uint32_t faded = ((w >> 1 & 0x7BEF7BEF) + (w >> 2 & 0x39E739E7)) &
+                     0xFFFEFFFE;
+    w = (w & keep) | (faded & ~keep);
+    if (swapped) w = (w & 0x00FF00FF) << 8 | (w >> 8 & 0x00FF00FF);
+    words[i] = w;
+  }
+}
@@ -0,0 +1,56 @@
+/*
+ * Fades every pixel of an RGB565 frame buffer a step towards black, so that
+ * anything drawn into it leaves a trail which dies away over the following
+ * frames. Two pixels are faded at a time in each 32 bit word. Pixels with the
+ * core flag set (the lowest bit of blue) are kept as they are, so things which
+ * have not moved can be left alone rather than drawn again after every fade.
+ * The fade can be run on core 1, in the background while core 0 gets on with
+ * other work.
+ *
+ * Copyright (c) 2025 Dr Footleg
+ *
+ * License: GNU GPL v3.0
+ */
+#pragma once
+
+#include <stdint.h>
+
+#include "libraries/pico_graphics/pico_graphics.hpp"
+
+using namespace pimoroni;
+
+class TrailFader {
+ public:
+  TrailFader(PicoGraphics_PenRGB565* display, uint16_t* buffer);
+
+  // Bit to set in a pen to keep pixels drawn with it from fading, in the pen
+  // order used by the display
+  uint16_t getCoreFlag() { return penSwapped ? 0x0100 : 0x0001; }
+
+  // Run fades on core 1 from now on. Core 1 must not be used for anything
+  // else.
+  void launchCore1();
+
+  // Start fading the buffer. On core 1 this returns straight away, so
+  // waitForFade must be called before drawing into the buffer again.
+  void startFade();
+  void waitForFade();
+
+  // Fade the buffer on the calling core
+  void fade();
+
+  // Fade pixels without the core flag to 3/4 of their brightness. Swapped
+  // pixels are in the byte swapped order PicoGraphics can use, and the count
+  // must be even.
+  static void fadePixels(uint16_t* pixels, uint32_t count, bool swapped);
+
+ private:
+  uint16_t* buffer;
+  uint16_t width;
+  uint16_t height;
+  bool penSwapped;  // Whether pens are byte swapped RGB565
+  bool onCore1 = false;
+  bool fading = false;
+
+  static void core1Worker();
+};
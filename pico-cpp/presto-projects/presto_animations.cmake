@@ -17,6 +17,15 @@ target_link_libraries(${OUTPUT_NAME}
   hardware_adc
   pico_graphics
   footleg_graphics
+  scan_beam
+  frame_pacer
+  bit_life
+  tiled_life
+  life_loader
+  trail_fader
+  cell_queue
+  sand_particles
+  tilt_sampler
   RGBMatrixRenderer
   Crawler
   GameOfLife
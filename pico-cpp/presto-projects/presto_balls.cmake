@@ -13,9 +13,11 @@ target_link_libraries(${OUTPUT_NAME} # <-- List libraries here!
   touchscreen
   lsm6ds3
   hardware_interp
+  hardware_dma
   hardware_adc
   pico_graphics
   footleg_graphics
+  presenter
 )
 
 # Enable USB UART output only
@@ -0,0 +1,21 @@
+set(OUTPUT_NAME presto_banded)
+
+add_executable(${OUTPUT_NAME} 
+  src/presto_banded.cpp # <-- Add source files here!
+)
+
+target_link_libraries(${OUTPUT_NAME} # <-- List libraries here!
+  st7701_presto
+  pico_stdlib
+  hardware_dma
+  pico_graphics
+  footleg_graphics
+  band_renderer
+)
+
+# Enable USB UART output only
+pico_enable_stdio_uart(${OUTPUT_NAME} 0)
+pico_enable_stdio_usb(${OUTPUT_NAME} 1)
+
+# create map/bin/hex file etc.
+pico_add_extra_outputs(${OUTPUT_NAME})
@@ -12,8 +12,10 @@ target_link_libraries(${OUTPUT_NAME} # <-- List libraries here!
   ft6x36
   touchscreen
   hardware_interp
+  hardware_dma
   hardware_adc
   pico_graphics
+  presenter
   footleg_graphics
   sparkfun_pico
 )
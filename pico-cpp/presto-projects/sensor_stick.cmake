@@ -10,8 +10,11 @@ target_link_libraries(${OUTPUT_NAME} # <-- List libraries here!
   pico_multicore
   pimoroni_i2c
   hardware_interp
+  hardware_dma
   hardware_adc
   pico_graphics
+  presenter
+  frame_pacer
   lsm6ds3
 )
 
@@ -9,7 +9,9 @@
  * License: GNU GPL v3.0
  */
 
+#include "../libraries/frame_pacer/frame_pacer.hpp"
 #include "../libraries/graphics/footleg_graphics.hpp"
+#include "../libraries/presenter/presenter.hpp"
 #include "drivers/st7701/st7701.hpp"
 #include "hardware/dma.h"
 #include "libraries/pico_graphics/pico_graphics.hpp"
@@ -44,6 +46,7 @@ uint16_t draw_buffer[FRAME_BUFFER_WIDTH * FRAME_BUFFER_HEIGHT];
 ST7701* presto;
 PicoGraphics_PenRGB565* display;
 FootlegGraphics* footlegGraphics;
+Presenter* presenter;
 PicoVector* vector;
 
 int main() {
@@ -61,6 +64,8 @@ int main() {
   display = new PicoGraphics_PenRGB565(FRAME_BUFFER_WIDTH, FRAME_BUFFER_HEIGHT,
                                        draw_buffer);
   footlegGraphics = new FootlegGraphics(display, draw_buffer);
+  presenter =
+      new Presenter(screen_buffer, FRAME_BUFFER_WIDTH, FRAME_BUFFER_HEIGHT);
   vector = new PicoVector(display);
   presto->init();
 
@@ -90,9 +95,12 @@ int main() {
 
   vector->translate(poly, {FRAME_BUFFER_WIDTH / 2.5, FRAME_BUFFER_HEIGHT / 2});
 
+  FramePacer pacer(40000);  // 25 fps
+  presenter->clearAsync(display, BG);
   while (true) {
-    display->set_pen(BG);
-    display->clear();
+    // Wait for the last frame to be presented and cleared by DMA before
+    // drawing over it
+    presenter->waitForDma();
 
     footlegGraphics->drawCircle(30, 30, 1, RED);
     footlegGraphics->drawCircle(80, 30, 2, ORANGE);
@@ -155,7 +163,9 @@ int main() {
 
     vector->draw(poly);
 
-    presto->update(display);
-    sleep_ms(40);
+    // Copy the frame to the screen and then clear it by DMA in the background
+    presenter->presentAsync(display);
+    presenter->clearAsync(display, BG);
+    pacer.waitForFrame();
   }
 }
\ No newline at end of file
@@ -3,8 +3,13 @@
  * Presto. A virtual LED matrix of variable resolutions is drawn on the screen
  * as circles. The size of the virtual LED matrix is controlled by touching the
  * top right or bottom right of the screen to set LED size. Press and hold on
- * the screen anywhere to toggle residual mode. Show/hide the text by touching
- * the top left of the screen. Switch animations by touching the bottom left.
+ * the screen anywhere to cycle residual, trails and plain modes. Show/hide
+ * the text by touching the top left of the screen. Switch animations by
+ * touching the bottom left.
+ * The particles fall the way the Presto is tilted, read from the accelerometer
+ * on the Qw/ST port.
+ * The last animation is a Game of Life world far larger than the screen, which
+ * can be panned around by dragging on the screen.
  *
  * Supports drawing at full screen resolution 480 x 480 by not using double
  * buffer. There is not enough RAM to support a double buffer of 480 x 480
@@ -18,11 +23,23 @@
 #include <math.h>
 #include <string.h>
 
+#include <algorithm>
 #include <cstdlib>
+#include <optional>
+#include <vector>
 
 #include "../drivers/lsm6ds3/lsm6ds3.hpp"
 #include "../drivers/touchscreen/touchscreen.hpp"
+#include "../libraries/bit_life/bit_life.hpp"
+#include "../libraries/cell_queue/cell_queue.hpp"
+#include "../libraries/frame_pacer/frame_pacer.hpp"
 #include "../libraries/graphics/footleg_graphics.hpp"
+#include "../libraries/life_loader/life_loader.hpp"
+#include "../libraries/sand_particles/sand_particles.hpp"
+#include "../libraries/tilt_sampler/tilt_sampler.hpp"
+#include "../libraries/scan_beam/scan_beam.hpp"
+#include "../libraries/tiled_life/tiled_life.hpp"
+#include "../libraries/trail_fader/trail_fader.hpp"
 #include "crawler.h"  //This is one of the animation classes used to generate output for the display
 #include "drivers/st7701/st7701.hpp"
 #include "golife.h"  //This is one of the animation classes used to generate output for the display
@@ -46,7 +63,10 @@ using namespace pimoroni;
 // uses a screen resolution of 480 x 480 without a double buffer.
 // Tearing is avoided by drawing cells directly to the screen or clearing
 // them by drawing over them in black, rather than clearing the whole screen
-// and redrawing it for each frame.
+// and redrawing it for each frame. Cells set during each cycle are compared
+// with what is already on screen, so only cells which changed are drawn. With
+// BEAM_RACING these are drawn a grid row at a time, only when that row is
+// clear of the rows the display is about to scan out.
 #define FRAME_BUFFER_WIDTH 480
 #define FRAME_BUFFER_HEIGHT 480
 
@@ -60,6 +80,23 @@ static const uint LCD_DAT = 27;
 static const uint LCD_DC = -1;
 static const uint LCD_D0 = 1;
 
+bool BEAM_RACING = true;
+// Rows ahead of the scan line which are not drawn into. A row of cells must be
+// drawn in the time the display takes to scan this many rows.
+static const int BEAM_AHEAD_ROWS = 48;
+// Time after which cells are drawn regardless, in case the scan line is stuck
+static const uint64_t BEAM_WAIT_LIMIT_US = 20000;
+// Minimum time per step of the crawler and particle animations
+static const uint32_t ANIMATION_STEP_US = 2000;
+// Run the animations on core 1, passing the cells they change through a queue
+// to core 0 to draw. Core 1 runs the next cycle while core 0 draws the last.
+// With trails, core 1 also fades the frame buffer at the end of each cycle.
+static const bool DUAL_CORE = true;
+// Cells which can be waiting to be collected before core 1 has to wait for
+// space. Core 0 collects them between drawing rows of cells as well as at the
+// end of each cycle, so this only needs to cover the time to draw a row.
+static const uint32_t CELL_QUEUE_SIZE = 1024;
+
 // Use one of these 3 buffer options. If using the psram buffer, then uncomment
 // the allocation line at the start of the main() function
 uint16_t screen_buffer[FRAME_BUFFER_WIDTH * FRAME_BUFFER_HEIGHT];
@@ -72,7 +109,13 @@ uint16_t* draw_buffer = screen_buffer;  // Single buffer (draw buffer mapped
 
 ST7701* presto;
 PicoGraphics_PenRGB565* display;
+ScanBeam* scanBeam;
+TrailFader* trailFader;
+CellQueue::Cell cellQueueStorage[CELL_QUEUE_SIZE];
+CellQueue cellQueue(cellQueueStorage, CELL_QUEUE_SIZE);
+uint32_t core1Stack[1024];
 LSM6DS3* accel;
+TiltSampler* tiltSampler;
 
 Pen BG;  // Set in main after display object has been created, but declared here
          // so globally accessible
@@ -88,6 +131,13 @@ static const uint TOUCH_HELD_TIME = 1000;
 static const uint TOUCH_CORNER_SIZE = 60;
 
 static const int ACC1G = 17000;      // Accelerometer reading for 1G
+// Angle of the Presto screen to its base (and the accelerometer) in radians
+static const float SCREEN_ANGLE = -0.932;
+// Particle acceleration for 1G, pulling the particles down the screen when
+// the Presto stands upright
+static const int16_t PARTICLE_1G = 150;
+// Time between accelerometer samples, at the 104Hz data rate it is set to
+static const uint32_t ACCEL_SAMPLE_US = 1000000 / 104;
 static const float gFactor = 0.2;    // Scale force to apply for gravity
 static const float friction = 0.99;  // Dampening factor (represents friction)
 
@@ -97,6 +147,7 @@ bool showText = true;
 static const uint8_t animModeGol = 0;
 static const uint8_t animModeCrawler = 1;
 static const uint8_t animModeParticles = 2;
+static const uint8_t animModeWorld = 3;
 
 uint16_t steps = 10;
 uint16_t minSteps = 2;
@@ -105,8 +156,27 @@ uint8_t golFadeSteps = 0;
 uint16_t golDelay = 100;
 uint8_t golStartPattern = 0;
 
+// Game of Life world much larger than the screen, with its tiles allocated in
+// PSRAM. The screen shows a window onto it, panned by dragging on the screen.
+static const uint16_t WORLD_TILES = 64;  // 4096 x 4096 cells
+// Empty tiles kept ready for the world to grow into, as core 1 cannot
+// allocate them while core 0 might be using malloc
+static const uint16_t WORLD_SPARE_TILES = 32;
+TiledLife* world;
+// The first pattern file (.rle or .cells) found in this folder on the SD card
+// is loaded into the world, in place of the built in patterns
+static const char* LIFE_PATTERN_DIR = "/life";
+int32_t worldViewX = 0;  // World cell shown in the top left grid cell
+int32_t worldViewY = 0;
+
 bool residual = true;
+// Instead of residual colour around each cell, fade the whole screen a little
+// each frame so that cells leave trails
+bool trails = false;
 uint16_t pixelsRedrawn = 0;
+// Animation cycles run, counted on whichever core runs them (to compare the
+// cycle rate with and without DUAL_CORE)
+volatile uint32_t cyclesRun = 0;
 
 // RGB Matrix class which passes itself as a renderer implementation into the
 // animation class. Needs to be declared before the global variable accesses it
@@ -122,18 +192,37 @@ class Animation : public RGBMatrixRenderer {
                           static_cast<uint16_t>(FRAME_BUFFER_HEIGHT /
                                                 ceil(pixScale * 1.2))},
         animCrawler(*this, steps_, minSteps_, false),
-        animGol(*this, golFadeSteps_, golDelay_, 0, golStartPattern_),
         animParticles(*this, shake, bounce_),
-        pixelSize(pixScale) {
-    footlegGraphics = new FootlegGraphics(display, draw_buffer);
-
-    // Clear screen
-    display->set_pen(BG);
-    display->clear();
+        particleShake(shake),
+        particleBounce(bounce_),
+        pixelSize(pixScale),
+        pacer(ANIMATION_STEP_US),
+        footlegGraphics(display, draw_buffer) {
+    // Size the cell buffers for the largest grid the first time through, so
+    // rebuilding the animation at another pixel size does not reallocate them
+    uint32_t maxCells = MAX_GRID_SIZE * MAX_GRID_SIZE;
+    presentedCells.reserve(maxCells);
+    cellSeen.reserve(maxCells);
+    changedCells.reserve(maxCells);
+    rowCells.reserve(maxCells);
+    rowStart.reserve(MAX_GRID_SIZE + 1);
+    rowDrawn.reserve(MAX_GRID_SIZE);
+    cellX.reserve(MAX_GRID_SIZE);
+    cellY.reserve(MAX_GRID_SIZE);
+    keptCells.reserve(maxCells);
+    // Drop any cells left from an animation with a different grid
+    pendingCells.clear();
 
     // Precalculate pixel radius
     rad = pixelSize / 2;  // - 1
     if (rad < 1) rad = 1;
+    buildCellGeometry();
+    for (auto& entry : penCache) entry.rgb = UINT32_MAX;
+
+    cellSeen.assign(getGridWidth() * getGridHeight(), false);
+    if (pixelSize > SAND_MAX_PIXEL_SIZE) sand.reset();
+    clearScreen();
+    startLife(golFadeSteps_, golDelay_, golStartPattern_);
 
     // Initialise mode
     aniMode = animModeGol;
@@ -141,40 +230,174 @@ class Animation : public RGBMatrixRenderer {
   }
 
   virtual ~Animation() {
+    finishCycle();
     // animGol.~GameOfLife();
     // animCrawler.~Crawler();
     // animParticles.~GravityParticles();
   }
 
+  // Restart the Game of Life with new settings, keeping the grid, the other
+  // animations and everything allocated for drawing. Changing the pixel size
+  // still needs a new Animation, as the grid size is fixed by the renderer.
+  void reconfigure(uint8_t golFadeSteps_, uint16_t golDelay_,
+                   uint8_t golStartPattern_) {
+    clearScreen();
+    startLife(golFadeSteps_, golDelay_, golStartPattern_);
+    setMode(animModeGol);
+  }
+
+  void clearScreen() {
+    finishCycle();
+    trailFader->waitForFade();
+    display->set_pen(BG);
+    display->clear();
+    presentedCells.assign(getGridWidth() * getGridHeight(), 0);
+  }
+
+  // Clear the screen and draw every lit cell again, for a change of drawing
+  // style. Only changed cells are drawn each frame, so the cells which have
+  // not changed would otherwise be lost.
+  void redrawScreen() {
+    finishCycle();
+    diffPendingCells();
+    uint16_t width = getGridWidth();
+    for (uint16_t y = 0; y < getGridHeight(); y++) {
+      for (uint16_t x = 0; x < width; x++) {
+        uint16_t key = presentedCells[y * width + x];
+        if (key) pendingCells.push_back({x, y, keyColour(key)});
+      }
+    }
+    clearScreen();
+  }
+
   void animationStep() {
     // (Don't clear screen as we are not using double buffer so we just draw
     // over pixels as they need updating)
     // display->set_pen(BG);
     // display->clear();
 
+    if (DUAL_CORE) {
+      // Collect the cells from the cycle core 1 is running, unless they were
+      // all collected while drawing the last frame, then set it going on the
+      // next cycle while this core draws them. The first cycle is run before
+      // there is anything to draw.
+      if (!cyclesStarted) {
+        startCycle();
+        cyclesStarted = true;
+      }
+      if (cycleRunning) finishCycle();
+      startCycle();
+    } else {
+      // Fade the trails left by the last frame on core 1 while the next one
+      // is worked out
+      if (trails) trailFader->startFade();
+      tiltSampler->poll();
+      prepareCycle();
+      runCycle();
+    }
+  }
+
+  // Loop run by core 1, running a cycle of the animation each time core 0
+  // asks for one. With trails the frame buffer is faded after the cycle, once
+  // core 0 has drawn the last one, so the cells of this cycle are drawn over
+  // the fade.
+  // Between cycles the accelerometer is sampled (at least once per cycle,
+  // when a sample is due), keeping its I2C reads off the core drawing the
+  // frames.
+  static void core1Main() {
+    while (true) {
+      do {
+        tiltSampler->poll();
+      } while (!multicore_fifo_rvalid());
+      uintptr_t request = multicore_fifo_pop_blocking();
+      Animation* animation = (Animation*)request;
+      animation->runCycle();
+      if (animation->fadeAfterCycle) {
+        while (!animation->frameDrawn) tight_loop_contents();
+        __dmb();
+        trailFader->fade();
+      }
+      cellQueue.pushEndOfCycle();
+    }
+  }
+
+  // Let core 1 use the frame buffer until the next cells are drawn
+  void releaseFrame() {
+    __dmb();
+    frameDrawn = true;
+  }
+
+  // Wait for core 1 to finish the cycle it is running, so that the animations
+  // can be changed from core 0
+  void finishCycle() {
+    if (!cycleRunning) return;
+    releaseFrame();
+    while (!collectCells()) tight_loop_contents();
+  }
+
+  // Move the cells core 1 has queued so far into pendingCells, to be drawn in
+  // the next frame. Returns true once the cycle has finished.
+  bool collectCells() {
+    if (!cycleRunning) return true;
+    CellQueue::Cell cell;
+    while (cellQueue.pop(cell)) {
+      if (cell.endOfCycle) {
+        cycleRunning = false;
+        return true;
+      }
+      pendingCells.push_back({cell.x, cell.y, {cell.r, cell.g, cell.b}});
+    }
+    return false;
+  }
+
+  void runCycle() {
     switch (aniMode) {
       case animModeGol:
-        animGol.runCycle();
+        if (bitLife) {
+          bitLifeCycle();
+        } else {
+          animGol->runCycle();
+        }
         break;
       case animModeCrawler:
         animCrawler.runCycle();
-        sleep_ms(1);
+        pacer.waitForFrame();
         break;
       case animModeParticles:
-        animParticles.runCycle();
-        if (cycles > 1000) {
-          cycles = 0;
-          animParticles.setAcceleration(100 - rand() % 200, 100 - rand() % 200);
+        tiltParticles();
+        if (sand) {
+          sand->step(setSandCell, this);
+        } else {
+          animParticles.runCycle();
         }
-        sleep_ms(1);
+        pacer.waitForFrame();
+        break;
+      case animModeWorld:
+        worldCycle();
+        pacer.waitForFrame();
         break;
     }
     cycles++;
+    cyclesRun = cyclesRun + 1;
   }
 
-  virtual void showPixels() { presto->update(display); }
+  // The animations can call this (through updateDisplay) and outputMessage
+  // part way through a cycle. On core 1 the cells are left for core 0 to draw
+  // at the end of the cycle, and messages are dropped, as core 0 writes its
+  // own line of text every frame. msSleep just holds up the cycle, so is safe
+  // on either core.
+  virtual void showPixels() {
+    if (DUAL_CORE && get_core_num() == 1) return;
+    diffPendingCells();
+    trailFader->waitForFade();
+    drawPendingCells();
+    presto->update(display);
+    if (DUAL_CORE) releaseFrame();
+  }
 
   virtual void outputMessage(char msg[]) {
+    if (DUAL_CORE && get_core_num() == 1) return;
+    trailFader->waitForFade();
     if (showText) {
       // Blank rectangle area of one line of text across top of screen
       display->set_pen(BG);
@@ -193,60 +416,163 @@ class Animation : public RGBMatrixRenderer {
   }
 
   void setMode(uint8_t mode) {
+    finishCycle();
     cycles = 0;
     aniMode = mode;
   }
 
   void setCrawlerMode(bool mode) { animCrawler.anyAngle = mode; }
 
-  void setParticles() {
-    // Set particles
-    animParticles.setAcceleration(0, 150);
+  // Animation steps which took longer than ANIMATION_STEP_US
+  uint32_t stepOverruns() { return pacer.overruns(); }
+
+  // Keep the cells on the screen, so the Animation rebuilt for a new pixel
+  // size can carry on from them
+  void keepImage() {
+    finishCycle();
+    diffPendingCells();
+    keptCells.assign(presentedCells.begin(), presentedCells.end());
+    keptWidth = getGridWidth();
+    keptHeight = getGridHeight();
+  }
 
-    animParticles.clearParticles();
-    animParticles.imgToParticles();
+  // Redraw the kept cells scaled to this grid (nearest neighbour), and carry
+  // on with the animation from them. The Game of Life from the animations
+  // library keeps its own cells, so it starts its pattern again instead.
+  void restoreImage(uint8_t mode) {
+    setMode(mode);
+    if (keptCells.empty() || (mode == animModeGol && !bitLife)) return;
+    if (mode == animModeWorld) {
+      // Drawn from the world at the new scale
+      setWorld();
+      return;
+    }
+
+    // Replaces the cells set by starting the Game of Life
+    pendingCells.clear();
+    bool seedLife = mode == animModeGol;
+    if (seedLife) {
+      bitLife->clear();
+      fadingCells.clear();
+      lifeSettledGenerations = 0;
+      lifeLastChanges = 0;
+    }
+    uint16_t width = getGridWidth();
+    uint16_t height = getGridHeight();
+    for (uint16_t y = 0; y < height; y++) {
+      const uint16_t* row = &keptCells[y * keptHeight / height * keptWidth];
+      for (uint16_t x = 0; x < width; x++) {
+        uint16_t key = row[x * keptWidth / width];
+        setPixelColour(x, y, keyColour(key));
+        if (key && seedLife) bitLife->setCell(x, y, true);
+      }
+    }
+    keptCells.clear();
+    updateDisplay();
+    if (mode == animModeParticles) setParticles();
   }
 
-  uint16_t particleCount() { return animParticles.getParticleCount(); }
+  void setParticles() {
+    finishCycle();
+    if (pixelSize <= SAND_MAX_PIXEL_SIZE) {
+      // Every lit cell on the screen becomes a particle
+      if (!sand) {
+        sand.emplace(getGridWidth(), getGridHeight(), particleShake,
+                     particleBounce);
+      } else {
+        sand->resize(getGridWidth(), getGridHeight());
+      }
+      uint16_t width = getGridWidth();
+      for (uint16_t y = 0; y < getGridHeight(); y++) {
+        for (uint16_t x = 0; x < width; x++) {
+          uint16_t key = presentedCells[y * width + x];
+          if (key) sand->addParticle(x, y, key);
+        }
+      }
+    } else {
+      sand.reset();
+      animParticles.clearParticles();
+      animParticles.imgToParticles();
+    }
+    setParticleAcceleration(0, PARTICLE_1G);
+  }
 
-  void drawLine(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2) {
-    // Get smaller and larger points
-    uint16_t xa = x1;
-    uint16_t xb = x2;
-    uint16_t ya = y1;
-    uint16_t yb = y2;
-    if (x2 < x1) {
-      xa = x2;
-      xb = x1;
-      ya = y2;
-      yb = y1;
+  void setParticleAcceleration(int16_t ax, int16_t ay) {
+    if (sand) {
+      sand->setAcceleration(ax, ay);
+    } else {
+      animParticles.setAcceleration(ax, ay);
     }
+  }
+
+  // Pull the particles towards the bottom of the tilted screen, using the last
+  // accelerometer sample
+  void tiltParticles() {
+    int16_t ax, ay;
+    if (tiltSampler->getAcceleration(ax, ay)) setParticleAcceleration(ax, ay);
+  }
 
+  uint32_t particleCount() {
+    return sand ? sand->getCount() : animParticles.getParticleCount();
+  }
+
+  void setWorld() {
+    finishCycle();
+    if (world->getAllocatedTiles() == 0 && !loadWorld()) seedWorld();
+    clampWorldView();
+    showWorld();
+  }
+
+  // Move the window onto the world by a distance in screen pixels
+  void panWorld(int dx, int dy) {
+    finishCycle();
+    int pitch = ceil(pixelSize * 1.2);
+    panX += dx;
+    panY += dy;
+    int cellsX = panX / pitch;
+    int cellsY = panY / pitch;
+    if (cellsX == 0 && cellsY == 0) return;
+    panX -= cellsX * pitch;
+    panY -= cellsY * pitch;
+    worldViewX -= cellsX;
+    worldViewY -= cellsY;
+    clampWorldView();
+    showWorld();
+  }
+
+  void drawLine(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2) {
     RGB_colour yellow = {255, 200, 120};
     RGB_colour red = {255, 0, 0};
     RGB_colour blue = {0, 0, 255};
 
-    if (xb - xa == 0) {
-      if (y2 > y1) {
-        ya = y1;
-        yb = y2;
-      } else {
-        ya = y2;
-        yb = y1;
+    // Bresenham line over the grid cells, so steep lines have a cell on every
+    // row. The cells go through the same shadow and diff as every other cell,
+    // so setting them back to black erases the line and trails fade it.
+    int x = x1;
+    int y = y1;
+    int dx = abs(x2 - x1);
+    int dy = -abs(y2 - y1);
+    int sx = x1 < x2 ? 1 : -1;
+    int sy = y1 < y2 ? 1 : -1;
+    int err = dx + dy;
+    while (true) {
+      setPixelColour(x, y, yellow);
+      if (x == x2 && y == y2) break;
+      int e2 = 2 * err;
+      if (e2 >= dy) {
+        err += dy;
+        x += sx;
       }
-      for (uint16_t y = ya; y <= yb; y++) {
-        setPixelColour(xa, y, yellow);
+      if (e2 <= dx) {
+        err += dx;
+        y += sy;
       }
-    } else {
-      for (uint16_t x = xa; x <= xb; x++) {
-        uint16_t y = ya + (yb - ya) * (x - xa) / (xb - xa);
-        setPixelColour(x, y, yellow);
-      }
-      // Mark ends
-      setPixelColour(x1, y1, red);
-      setPixelColour(x2, y2, blue);
     }
 
+    // Mark ends
+    setPixelColour(x1, y1, red);
+    setPixelColour(x2, y2, blue);
+
     updateDisplay();
   }
 
@@ -263,42 +589,507 @@ class Animation : public RGBMatrixRenderer {
   Pen PINK = display->create_pen(192, 0, 128);
   Pen PURPLE = display->create_pen(128, 0, 128);
   Crawler animCrawler;
-  GameOfLife animGol;
+  std::optional<GameOfLife> animGol;
+  // Used in place of animGol for the random start pattern on the larger
+  // grids, where calculating each generation a cell at a time is too slow
+  static const uint8_t BIT_LIFE_MAX_PIXEL_SIZE = 2;
+  // Generations with the same number of changed cells before restarting
+  static const uint16_t BIT_LIFE_RESTART_GENERATIONS = 200;
+  static const uint8_t BIT_LIFE_DENSITY = 64;  // Chance of life out of 256
+  std::optional<BitLife> bitLife;
+  uint8_t lifeFadeSteps;
+  uint16_t lifeSettledGenerations;
+  uint32_t lifeLastChanges;
+  // Cells which died in recent generations and are fading out
+  struct FadingCell {
+    uint16_t x;
+    uint16_t y;
+    uint8_t age;
+  };
+  std::vector<FadingCell> fadingCells;
+  bool cycleRunning = false;  // Core 1 is running a cycle
+  bool cyclesStarted = false;  // The first cycle has been run on core 1
+  // Core 1 fades the frame buffer after the cycle it is running, once core 0
+  // has finished drawing into it
+  bool fadeAfterCycle = false;
+  volatile bool frameDrawn = false;
+  int panX = 0;  // Screen pixels dragged but not yet moved by a whole cell
+  int panY = 0;
   GravityParticles animParticles;
+  // Used in place of animParticles on the larger grids, where there can be
+  // tens of thousands of particles. Shared by every Animation, so a rebuild
+  // for a new pixel size keeps its storage.
+  static const uint8_t SAND_MAX_PIXEL_SIZE = 3;
+  inline static std::optional<SandParticles> sand;
+  uint16_t particleShake;
+  uint8_t particleBounce;
   uint8_t aniMode;
   uint16_t cycles;
   uint8_t pixelSize;
-  FootlegGraphics* footlegGraphics;
+  FramePacer pacer;
+  FootlegGraphics footlegGraphics;
+
+  // Grid width and height at the smallest pixel size
+  static const uint16_t MAX_GRID_SIZE = FRAME_BUFFER_WIDTH / 2;
+
+  // The cell buffers below are shared by every Animation, so they outlive a
+  // rebuild for a new pixel size and keep their capacity.
+
+  // Cells set since the last showPixels, in the order they were set. With
+  // trails, cells which have gone out are drawn in their old colour to fade.
+  struct PendingCell {
+    uint16_t x;
+    uint16_t y;
+    RGB_colour colour;
+    bool fade = false;
+  };
+  inline static std::vector<PendingCell> pendingCells;
+  // Colour on the screen of each cell (as RGB565), so cells set back to the
+  // colour they already show are not drawn again
+  inline static std::vector<uint16_t> presentedCells;
+  // Cells already diffed this cycle
+  inline static std::vector<bool> cellSeen;
+  // Cells to draw this cycle
+  inline static std::vector<PendingCell> changedCells;
+  // Changed cells grouped by grid row
+  inline static std::vector<PendingCell> rowCells;
+  // Index of each grid row in rowCells
+  inline static std::vector<uint32_t> rowStart;
+  // Next free place in rowCells for each grid row, while grouping
+  inline static std::vector<uint32_t> rowNext;
+  inline static std::vector<bool> rowDrawn;
+
+  // Screen position of each grid column and row. This is the top left of the
+  // cell for cells under 3 pixels, and the cell centre for larger cells.
+  inline static std::vector<uint16_t> cellX;
+  inline static std::vector<uint16_t> cellY;
+
+  // Cells kept by keepImage, for the Animation rebuilt at a new pixel size
+  inline static std::vector<uint16_t> keptCells;
+  inline static uint16_t keptWidth = 0;
+  inline static uint16_t keptHeight = 0;
+  uint16_t cellRad;       // Radius of a cell on the screen
+  uint16_t cellOuterRad;  // Radius including the residual surround
+  uint16_t textRows;      // Grid rows under the line of text
+
+  // Pens for recently drawn colours, with the faint pen used for residual
+  // trails. Indexed by a hash of the colour.
+  struct PenCacheEntry {
+    uint32_t rgb;  // UINT32_MAX for an unused entry
+    Pen pen;
+    Pen faint;
+  };
+  static const int PEN_CACHE_SIZE = 64;
+  PenCacheEntry penCache[PEN_CACHE_SIZE];
+
+  void startLife(uint8_t golFadeSteps_, uint16_t golDelay_,
+                 uint8_t golStartPattern_) {
+    if (pixelSize <= BIT_LIFE_MAX_PIXEL_SIZE && golStartPattern_ == 0) {
+      animGol.reset();
+      if (!bitLife) bitLife.emplace(getGridWidth(), getGridHeight());
+      // Room for every cell to be fading, so a cycle on core 1 never has to
+      // grow the vector
+      fadingCells.reserve(getGridWidth() * getGridHeight());
+      lifeFadeSteps = golFadeSteps_;
+      seedBitLife();
+    } else {
+      bitLife.reset();
+      animGol.emplace(*this, golFadeSteps_, golDelay_, 0, golStartPattern_);
+    }
+  }
+
+  void seedBitLife() {
+    bitLife->randomise(BIT_LIFE_DENSITY);
+    fadingCells.clear();
+    lifeSettledGenerations = 0;
+    lifeLastChanges = 0;
+    RGB_colour black = {0, 0, 0};
+    for (uint16_t y = 0; y < getGridHeight(); y++) {
+      for (uint16_t x = 0; x < getGridWidth(); x++) {
+        setPixelColour(x, y, bitLife->getCell(x, y) ? lifeColour(x, y) : black);
+      }
+    }
+  }
+
+  void bitLifeCycle() {
+    uint32_t changes = bitLife->step();
+
+    // Dim the cells fading out from earlier generations, unless they came
+    // back to life
+    RGB_colour black = {0, 0, 0};
+    for (size_t i = 0; i < fadingCells.size();) {
+      FadingCell& cell = fadingCells[i];
+      if (bitLife->getCell(cell.x, cell.y) || --cell.age == 0) {
+        if (cell.age == 0) setPixelColour(cell.x, cell.y, black);
+        cell = fadingCells.back();
+        fadingCells.pop_back();
+      } else {
+        setPixelColour(cell.x, cell.y,
+                       fadedLifeColour(cell.x, cell.y, cell.age));
+        i++;
+      }
+    }
+
+    // Draw the cells born or died in this generation
+    uint16_t words = bitLife->getWordsPerRow();
+    for (uint16_t y = 0; y < getGridHeight(); y++) {
+      const uint32_t* changed = bitLife->changedRow(y);
+      for (uint16_t i = 0; i < words; i++) {
+        for (uint32_t bits = changed[i]; bits; bits &= bits - 1) {
+          uint16_t x = i * 32 + __builtin_ctz(bits);
+          if (bitLife->getCell(x, y)) {
+            setPixelColour(x, y, lifeColour(x, y));
+          } else if (lifeFadeSteps > 0) {
+            fadingCells.push_back({x, y, lifeFadeSteps});
+            setPixelColour(x, y, fadedLifeColour(x, y, lifeFadeSteps));
+          } else {
+            setPixelColour(x, y, black);
+          }
+        }
+      }
+    }
+
+    // Start again once the pattern has settled down
+    if (changes == lifeLastChanges) {
+      lifeSettledGenerations++;
+    } else {
+      lifeSettledGenerations = 0;
+    }
+    lifeLastChanges = changes;
+    if (lifeSettledGenerations > BIT_LIFE_RESTART_GENERATIONS) seedBitLife();
+  }
+
+  // Live cells take their colour from a rainbow across the grid diagonal
+  RGB_colour lifeColour(uint16_t x, uint16_t y) {
+    uint16_t hue = (x + y) * 1535 / (getGridWidth() + getGridHeight());
+    uint8_t rise = hue & 0xFF;
+    uint8_t fall = 255 - rise;
+    switch (hue >> 8) {
+      case 0:
+        return {255, rise, 0};
+      case 1:
+        return {fall, 255, 0};
+      case 2:
+        return {0, 255, rise};
+      case 3:
+        return {0, fall, 255};
+      case 4:
+        return {rise, 0, 255};
+      default:
+        return {255, 0, fall};
+    }
+  }
+
+  RGB_colour fadedLifeColour(uint16_t x, uint16_t y, uint8_t age) {
+    RGB_colour colour = lifeColour(x, y);
+    uint16_t level = age * 256 / (lifeFadeSteps + 1);
+    return {uint8_t(colour.r * level >> 8), uint8_t(colour.g * level >> 8),
+            uint8_t(colour.b * level >> 8)};
+  }
+
+  uint32_t golIteration() {
+    return bitLife ? bitLife->getGeneration() : animGol->getIteration();
+  }
+
+  RGB_colour golCellColour(uint16_t x, uint16_t y) {
+    return bitLife ? lifeColour(x, y) : animGol->getCellColour(x, y);
+  }
+
+  // Fill the middle of the world with glider guns and patches of random soup
+  void seedWorld() {
+    static const char* gliderGun[] = {
+        "........................O...........",
+        "......................O.O...........",
+        "............OO......OO............OO",
+        "...........O...O....OO............OO",
+        "OO........O.....O...OO..............",
+        "OO........O...O.OO....O.O...........",
+        "..........O.....O.......O...........",
+        "...........O...O....................",
+        "............OO......................"};
+    uint32_t centreX = world->getWidth() / 2;
+    uint32_t centreY = world->getHeight() / 2;
+    for (int gun = 0; gun < 4; gun++) {
+      uint32_t gunX = centreX - 200 + gun * 100;
+      uint32_t gunY = centreY - 200 + gun * 60;
+      for (int y = 0; y < 9; y++) {
+        for (int x = 0; gliderGun[y][x]; x++) {
+          if (gliderGun[y][x] == 'O') world->setCell(gunX + x, gunY + y, true);
+        }
+      }
+    }
+    for (int soup = 0; soup < 6; soup++) {
+      uint32_t soupX = centreX - 300 + rand() % 600;
+      uint32_t soupY = centreY - 300 + rand() % 600;
+      for (uint32_t y = soupY; y < soupY + 48; y++) {
+        for (uint32_t x = soupX; x < soupX + 48; x++) {
+          if (rand() % 3 == 0) world->setCell(x, y, true);
+        }
+      }
+    }
+    worldViewX = centreX - getGridWidth() / 2;
+    worldViewY = centreY - getGridHeight() / 2;
+  }
+
+  // Load a pattern from the SD card into the middle of the world
+  bool loadWorld() {
+    char path[80];
+    if (!findLifePattern(LIFE_PATTERN_DIR, path, sizeof(path))) return false;
+    uint32_t centreX = world->getWidth() / 2;
+    uint32_t centreY = world->getHeight() / 2;
+    LifeParser parser(setWorldCell, world, centreX, centreY);
+    parser.centreOn(centreX, centreY);
+    LifeLoadStats stats;
+    if (!loadLifePattern(path, parser, stats)) return false;
+    printf("Loaded %s: %lux%lu, %lu cells from %lu bytes in %lums\n", path,
+           parser.getWidth(), parser.getHeight(), parser.getLiveCells(),
+           stats.bytes, stats.timeUs / 1000);
+    worldViewX = centreX - getGridWidth() / 2;
+    worldViewY = centreY - getGridHeight() / 2;
+    return parser.getLiveCells() > 0;
+  }
+
+  static void setWorldCell(void* context, uint32_t x, uint32_t y) {
+    ((TiledLife*)context)->setCell(x, y, true);
+  }
+
+  void clampWorldView() {
+    int32_t maxX = world->getWidth() - getGridWidth();
+    int32_t maxY = world->getHeight() - getGridHeight();
+    worldViewX = worldViewX < 0 ? 0 : (worldViewX > maxX ? maxX : worldViewX);
+    worldViewY = worldViewY < 0 ? 0 : (worldViewY > maxY ? maxY : worldViewY);
+  }
+
+  // Draw every cell in the window onto the world
+  void showWorld() {
+    RGB_colour black = {0, 0, 0};
+    for (uint16_t y = 0; y < getGridHeight(); y++) {
+      for (uint16_t x = 0; x < getGridWidth(); x++) {
+        bool alive = world->getCell(worldViewX + x, worldViewY + y);
+        setPixelColour(x, y, alive ? lifeColour(x, y) : black);
+      }
+    }
+  }
+
+  void worldCycle() {
+    world->step();
+
+    // Redraw the part of the window over each tile which changed
+    RGB_colour black = {0, 0, 0};
+    const uint16_t size = TiledLife::TILE_SIZE;
+    int32_t right = worldViewX + getGridWidth();
+    int32_t bottom = worldViewY + getGridHeight();
+    for (int32_t ty = worldViewY / size; ty * size < bottom; ty++) {
+      for (int32_t tx = worldViewX / size; tx * size < right; tx++) {
+        if (!world->tileChanged(tx, ty)) continue;
+        int32_t x1 = std::max(tx * size, worldViewX);
+        int32_t x2 = std::min((tx + 1) * size, right);
+        int32_t y1 = std::max(ty * size, worldViewY);
+        int32_t y2 = std::min((ty + 1) * size, bottom);
+        for (int32_t y = y1; y < y2; y++) {
+          const uint32_t* row = world->tileRow(tx, ty, y - ty * size);
+          for (int32_t x = x1; x < x2; x++) {
+            uint16_t cellX = x - worldViewX;
+            uint16_t cellY = y - worldViewY;
+            bool alive = (row[(x % size) / 32] >> (x & 31)) & 1;
+            setPixelColour(cellX, cellY,
+                           alive ? lifeColour(cellX, cellY) : black);
+          }
+        }
+      }
+    }
+  }
+
+  void buildCellGeometry() {
+    int pitch = ceil(pixelSize * 1.2);
+    int offset = ceil(pixelSize * 0.6);
+    int scaleX = 480 / display->bounds.w;
+    int scaleY = 480 / display->bounds.h;
+    cellX.resize(getGridWidth());
+    cellY.resize(getGridHeight());
+    for (uint16_t x = 0; x < cellX.size(); x++) {
+      cellX[x] = pixelSize < 3 ? x * pitch : (x * pitch + offset) * scaleX;
+    }
+    for (uint16_t y = 0; y < cellY.size(); y++) {
+      cellY[y] = pixelSize < 3 ? y * pitch : (y * pitch + offset) * scaleY;
+    }
+    cellRad = rad * scaleX;
+    cellOuterRad = (rad + 2) * scaleX;
+    textRows = 12 / (pixelSize + 1);
+  }
+
+  const PenCacheEntry& cachedPens(RGB_colour colour) {
+    uint32_t rgb = colour.r << 16 | colour.g << 8 | colour.b;
+    PenCacheEntry& entry =
+        penCache[(rgb ^ (rgb >> 7) ^ (rgb >> 13)) % PEN_CACHE_SIZE];
+    if (entry.rgb != rgb) {
+      entry.rgb = rgb;
+      entry.pen = display->create_pen(colour.r, colour.g, colour.b);
+      entry.faint =
+          display->create_pen(colour.r / 3, colour.g / 3, colour.b / 3);
+    }
+    return entry;
+  }
 
   virtual void setPixel(uint16_t x, uint16_t y, RGB_colour colour) {
-    if (!showText || y > floor(12 / (pixelSize + 1))) {
+    // Drawn in showPixels, once the cycle has finished changing cells
+    if (DUAL_CORE && get_core_num() == 1) {
+      cellQueue.push({x, y, colour.r, colour.g, colour.b, false});
+    } else {
+      pendingCells.push_back({x, y, colour});
+    }
+  }
+
+  // Allocate anything the next cycle needs, before it runs
+  void prepareCycle() {
+    if (aniMode == animModeWorld) world->reserveTiles(WORLD_SPARE_TILES);
+  }
+
+  void startCycle() {
+    prepareCycle();
+    fadeAfterCycle = trails;
+    frameDrawn = false;
+    multicore_fifo_push_blocking((uintptr_t)this);
+    cycleRunning = true;
+  }
+
+  static uint16_t colourKey(RGB_colour colour) {
+    return (colour.r & 0xF8) << 8 | (colour.g & 0xFC) << 3 | colour.b >> 3;
+  }
+
+  static RGB_colour keyColour(uint16_t key) {
+    return {uint8_t(key >> 8 & 0xF8), uint8_t(key >> 3 & 0xFC),
+            uint8_t(key << 3)};
+  }
+
+  // Sand particles keep their colour as a key, with 0 for an empty cell
+  static void setSandCell(void* context, uint16_t x, uint16_t y,
+                          uint16_t colour) {
+    ((Animation*)context)->setPixelColour(x, y, keyColour(colour));
+  }
+
+  void diffPendingCells() {
+    // Work back from the last cell set, so the first time each cell is seen
+    // has its final colour for this cycle. Cells which finish the cycle the
+    // colour they already show (such as ones set and then cleared again) are
+    // dropped.
+    uint16_t width = getGridWidth();
+    changedCells.clear();
+    for (size_t i = pendingCells.size(); i-- > 0;) {
+      const PendingCell& cell = pendingCells[i];
+      uint32_t idx = cell.y * width + cell.x;
+      if (cellSeen[idx]) continue;
+      cellSeen[idx] = true;
+      uint16_t key = colourKey(cell.colour);
+      uint16_t oldKey = presentedCells[idx];
+      if (oldKey == key) continue;
+      presentedCells[idx] = key;
+      if (trails && key == 0) {
+        changedCells.push_back({cell.x, cell.y, keyColour(oldKey), true});
+      } else {
+        changedCells.push_back(cell);
+      }
+    }
+    for (auto& cell : pendingCells) cellSeen[cell.y * width + cell.x] = false;
+    pendingCells.clear();
+  }
+
+  void drawPendingCells() {
+    if (changedCells.empty()) return;
+
+    // Group the cells by grid row
+    uint16_t rows = getGridHeight();
+    rowStart.assign(rows + 1, 0);
+    for (auto& cell : changedCells) rowStart[cell.y + 1]++;
+    for (uint16_t r = 0; r < rows; r++) rowStart[r + 1] += rowStart[r];
+    rowCells.resize(changedCells.size());
+    rowNext.clear();
+    rowNext.insert(rowNext.end(), rowStart.begin(), rowStart.end() - 1);
+    for (auto& cell : changedCells) rowCells[rowNext[cell.y]++] = cell;
+
+    // Screen rows a grid row of cells can draw on, including the residual
+    // surround which extends into the neighbouring rows
+    int pitch = ceil(pixelSize * 1.2);
+    if (pitch < 1) pitch = 1;
+
+    // Work down the screen from the first grid row clear of the beam, as the
+    // beam takes longest to reach it. Rows which are not clear when they are
+    // reached are left for the next pass, after the beam has moved on. The
+    // beam only matters when drawing straight into the scan-out buffer.
+    bool race = BEAM_RACING && draw_buffer == screen_buffer;
+    int beam = race ? scanBeam->row() : -1;
+    int startRow = beam < 0 ? 0 : (beam + BEAM_AHEAD_ROWS) / pitch + 2;
+    rowDrawn.assign(rows, false);
+    uint16_t remaining = 0;
+    for (uint16_t r = 0; r < rows; r++) {
+      if (rowStart[r] == rowStart[r + 1]) {
+        rowDrawn[r] = true;
+      } else {
+        remaining++;
+      }
+    }
+    uint64_t giveUp = time_us_64() + BEAM_WAIT_LIMIT_US;
+    while (remaining > 0) {
+      bool waited = !race || time_us_64() > giveUp;
+      for (uint16_t i = 0; i < rows; i++) {
+        uint16_t r = (startRow + i) % rows;
+        if (rowDrawn[r]) continue;
+        if (!waited && !scanBeam->clear((r - 1) * pitch, (r + 2) * pitch,
+                                        BEAM_AHEAD_ROWS))
+          continue;
+        for (uint32_t c = rowStart[r]; c < rowStart[r + 1]; c++) {
+          const PendingCell& cell = rowCells[c];
+          drawCell(cell.x, cell.y, cell.colour, cell.fade);
+        }
+        rowDrawn[r] = true;
+        remaining--;
+        // Keep core 1 from filling the queue and waiting for this frame
+        if (DUAL_CORE) collectCells();
+      }
+      if (DUAL_CORE) collectCells();
+    }
+  }
+
+  void drawCell(uint16_t x, uint16_t y, RGB_colour colour, bool fade) {
+    if (!showText || y > textRows) {
+      const PenCacheEntry& pens = cachedPens(colour);
+      Pen pen = pens.pen;
       pixelsRedrawn++;
-      Pen pen = display->create_pen(colour.r, colour.g, colour.b);
-      if (pixelSize == 0) {
+      if (trails && pixelSize > 0) {
+        // Only the core of a cell is drawn with trails. Lit cores carry the
+        // core flag so the fade leaves them alone, and cells which have gone
+        // out are drawn again without it to start fading.
+        uint16_t coreFlag = trailFader->getCoreFlag();
+        pen = fade ? pen & ~coreFlag : pen | coreFlag;
+        if (pixelSize < 3) {
+          display->set_pen(pen);
+          display->rectangle({cellX[x], cellY[y], pixelSize, pixelSize});
+        } else {
+          // Not AA, so no edge pixel is left part flagged
+          footlegGraphics.drawCircle(cellX[x], cellY[y], cellRad, pen);
+        }
+      } else if (pixelSize == 0) {
         // Not using this for single pixels now, as not enough RAM to handle 1:1
         // pixel mapping on screen. This would only use 1/4 of the screen.
         // Instead for pixel size of 1 we draw alternate pixels as cells.
         display->set_pen(pen);
         display->set_pixel(Point(x, y));
       } else if (pixelSize < 3) {
-        uint16_t scrnX = x * ceil(pixelSize * 1.2);
-        uint16_t scrnY = y * ceil(pixelSize * 1.2);
+        uint16_t scrnX = cellX[x];
+        uint16_t scrnY = cellY[y];
         if (residual &&
-            (aniMode != animModeGol || animGol.getIteration() > 4)) {
+            (aniMode != animModeGol || golIteration() > 4)) {
           if (pen > 0) {
             // Draw surround to enables trails in non=GOL modes
             if (aniMode != animModeGol) {
-              RGB rgb = PicoGraphics::rgb565_to_rgb(pen);
-              Pen faintPen =
-                  display->create_pen(rgb.r / 3, rgb.g / 3, rgb.b / 3);
-              footlegGraphics->drawCircleAA(scrnX, scrnY, pixelSize, faintPen);
+              footlegGraphics.drawCircleAA(scrnX, scrnY, pixelSize,
+                                            pens.faint);
             }
             display->set_pen(pen);
             // Draw square pixel
             display->rectangle({scrnX, scrnY, pixelSize, pixelSize});
           } else {
-            RGB_colour rgb = animGol.getCellColour(x, y);
-            Pen erase = display->create_pen(rgb.r / 3, rgb.g / 3, rgb.b / 3);
+            Pen erase = cachedPens(golCellColour(x, y)).faint;
             // Draw surround
             display->set_pen(erase);
             display->rectangle(
@@ -316,37 +1107,26 @@ class Animation : public RGBMatrixRenderer {
           }
         }
       } else {
-        uint16_t scrnX = (x * ceil(pixelSize * 1.2) + ceil(pixelSize * 0.6)) *
-                         (480 / display->bounds.w);
-        uint16_t scrnY = (y * ceil(pixelSize * 1.2) + ceil(pixelSize * 0.6)) *
-                         (480 / display->bounds.h);
+        uint16_t scrnX = cellX[x];
+        uint16_t scrnY = cellY[y];
         if (residual &&
-            (aniMode != animModeGol || animGol.getIteration() > 4)) {
-          Pen erase =
-              display->create_pen(colour.r / 3, colour.g / 3, colour.b / 3);
+            (aniMode != animModeGol || golIteration() > 4)) {
           if (pen > 0) {
-            // Draw larger faint colour surround for cell to create residual
-            // colour
-            footlegGraphics->drawCircle(
-                scrnX, scrnY, (rad + 2) * (480 / display->bounds.w), erase);
-            // Draw actual cell
-            footlegGraphics->drawCircleAA(scrnX, scrnY,
-                                          rad * (480 / display->bounds.w), pen);
+            // Draw actual cell inside a larger faint colour surround to create
+            // residual colour, writing each pixel once
+            footlegGraphics.drawRing(scrnX, scrnY, cellRad, cellOuterRad,
+                                      pen, pens.faint);
           } else {
             // Wipe centre of cell with residual colour from GOL cells array
-            RGB_colour rgb = animGol.getCellColour(x, y);
-            erase = display->create_pen(rgb.r / 3, rgb.g / 3, rgb.b / 3);
-            footlegGraphics->drawCircle(scrnX, scrnY,
-                                        rad * (480 / display->bounds.w), erase);
+            Pen erase = cachedPens(golCellColour(x, y)).faint;
+            footlegGraphics.drawCircle(scrnX, scrnY, cellRad, erase);
           }
         } else {
           if (pen == 0) {
             // Clear pixel with larger circle
-            footlegGraphics->drawCircle(
-                scrnX, scrnY, (rad + 2) * (480 / display->bounds.w), BG);
+            footlegGraphics.drawCircle(scrnX, scrnY, cellOuterRad, BG);
           } else {
-            footlegGraphics->drawCircleAA(scrnX, scrnY,
-                                          rad * (480 / display->bounds.w), pen);
+            footlegGraphics.drawCircleAA(scrnX, scrnY, cellRad, pen);
           }
         }
       }
@@ -364,6 +1144,13 @@ int main() {
   uint16_t frame_counter, lastFC = 0;
   uint64_t start_fps, elapsed, lastSettingsChange;  // Microsecond times
   double fps = 0.0f, prevFps = 0.0f;  // Frames per second to display
+  uint32_t windowRedrawn = 0;  // Cells redrawn since start_fps
+  uint32_t redrawRate = 0;     // Cells redrawn per second
+  uint32_t startCycles = 0;    // cyclesRun at start_fps
+  uint32_t cycleRate = 0;      // Animation cycles run per second
+
+  // USB output, for the pattern file loading report
+  stdio_init_all();
 
   // Initialise random numbers seed using floating adc input reading
   adc_init();
@@ -386,6 +1173,7 @@ int main() {
   sfe_setup_psram(47);
   sfe_pico_alloc_init();
   // draw_buffer = (uint16_t*)malloc(DRAW_BUF_SIZE);
+  world = new TiledLife(WORLD_TILES, WORLD_TILES);
 
   presto = new ST7701(
       FRAME_BUFFER_WIDTH, FRAME_BUFFER_HEIGHT, ROTATE_0,
@@ -394,6 +1182,10 @@ int main() {
   display = new PicoGraphics_PenRGB565(FRAME_BUFFER_WIDTH, FRAME_BUFFER_HEIGHT,
                                        draw_buffer);
 
+  scanBeam =
+      new ScanBeam(screen_buffer, FRAME_BUFFER_WIDTH, FRAME_BUFFER_HEIGHT);
+  trailFader = new TrailFader(display, draw_buffer);
+  if (!DUAL_CORE) trailFader->launchCore1();
   presto->init();
 
   BG = display->create_pen(0, 0, 0);
@@ -403,7 +1195,10 @@ int main() {
 
   static I2C i2c_qwst(40, 41);
   accel = new LSM6DS3(&i2c_qwst);
-  LSM6DS3::SensorData acceldata;
+  // Sampled from the animation core between cycles (see poll), so the I2C
+  // reads never hold up drawing and only one core uses the Qw/ST bus
+  tiltSampler = new TiltSampler(accel, SCREEN_ANGLE, ACC1G, PARTICLE_1G);
+  tiltSampler->start(ACCEL_SAMPLE_US);
 
   // Set up animation vars
   uint16_t shake = 100;
@@ -417,9 +1212,16 @@ int main() {
 
   Animation animation(pixelSize, steps, minSteps, golFadeSteps, golDelay,
                       golStartPattern, shake, bounce);
+  if (DUAL_CORE) {
+    multicore_launch_core1_with_stack(Animation::core1Main, core1Stack,
+                                      sizeof(core1Stack));
+  }
 
   Point text_location(5, 5);
   Point lastTouch(0, 0);
+  Point dragFrom(0, 0);
+  bool dragging = false;  // Touch is being dragged to pan the world
+  bool dragged = false;   // The world was panned during this touch
 
   // Get the start time (used to calculate fps)
   start_fps = time_us_64();
@@ -439,6 +1241,19 @@ int main() {
 
     // Check whether the touch screen is being touched right now
     if (touch.read()) {
+      if (animationMode == animModeWorld) {
+        // Drag the window onto the world around with the touch
+        Point touchPoint = touch.last_touched_point();
+        if (dragging && (touchPoint.x != dragFrom.x ||
+                         touchPoint.y != dragFrom.y)) {
+          animation.panWorld(touchPoint.x - dragFrom.x,
+                             touchPoint.y - dragFrom.y);
+          dragged = true;
+        }
+        dragFrom = touchPoint;
+        dragging = true;
+      }
+
       // Check how long this touch has been going on for
       uint32_t btn_held_for = touch.held_for();
       if (btn_held_for > TOUCH_HELD_TIME) {
@@ -452,6 +1267,8 @@ int main() {
           // Create circle at position of touch (until released)
         }
       }
+    } else {
+      dragging = false;
     }
 
     // Check and act on button press-release events
@@ -464,6 +1281,8 @@ int main() {
         // Button was pressed and released. Take action based on how long it was
         // down for here
         Point touchPoint = touch.last_touched_point();
+        bool wasDragged = dragged;
+        dragged = false;
         if (checkBtn < TOUCH_HELD_TIME) {
           // Touch screen press+release event. Take actions based on where on
           // the screen was clicked (touch screen returns full resolution
@@ -478,12 +1297,15 @@ int main() {
             } else if (touchPoint.y > touch.bounds.h - TOUCH_CORNER_SIZE) {
               // Bottom Left Corner
               animationMode++;
-              if (animationMode > 2) animationMode = 0;
+              if (animationMode > 3) animationMode = 0;
               animation.setMode(animationMode);
 
               // Clear all pixels or convert to particles
               if (animationMode == animModeParticles) {
                 animation.setParticles();
+              } else if (animationMode == animModeWorld) {
+                animation.clearImage();
+                animation.setWorld();
               } else {
                 animation.clearImage();
               }
@@ -509,6 +1331,9 @@ int main() {
             }
           }
 
+          // Dragging the world around is not a press
+          if (wasDragged) actionTaken = true;
+
           if (actionTaken == false) {
             // Press/release was not in any special screen area.
             if (checkBtn < TOUCH_SHORT_PRESS_TIME) {
@@ -516,15 +1341,21 @@ int main() {
               // Create a ball at position of touch
             } else {
               // Long press anywhere but the screen corners
-              // Toggle residual graphics feature
-              residual = !residual;
+              // Cycle through residual graphics, trails and plain cells
+              if (residual) {
+                residual = false;
+                trails = true;
+              } else if (trails) {
+                trails = false;
+              } else {
+                residual = true;
+              }
               if (residual) {
                 animation.residual = 50;
               } else {
                 animation.residual = 0;
               }
-              display->set_pen(BG);
-              display->clear();
+              animation.redrawScreen();
               lastSettingsChange = time_us_64();
             }
           }
@@ -538,9 +1369,16 @@ int main() {
                              // check if reset calc window is needed
 
     fps = float(frame_counter) * 1000000.0f / float(elapsed - start_fps);
+    windowRedrawn += pixelsRedrawn;
 
     // Reset times over which fps is calculated every 4 seconds
     if (elapsed - start_fps > 4000000) {
+      redrawRate = uint64_t(windowRedrawn) * 1000000 / (elapsed - start_fps);
+      uint32_t cyclesNow = cyclesRun;
+      cycleRate =
+          uint64_t(cyclesNow - startCycles) * 1000000 / (elapsed - start_fps);
+      startCycles = cyclesNow;
+      windowRedrawn = 0;
       frame_counter = 0;
       start_fps = elapsed;
       prevFps = fps;
@@ -553,12 +1391,14 @@ int main() {
 
     // Update text for information shown on screen
     char prefix[48];
-    char suffix[48];
+    char suffix[80];
 
     lastTouch = touch.last_touched_point();
     sprintf(prefix, " WxH:%ix%i ", display->bounds.w, display->bounds.h);
 
-    sprintf(suffix, "size:%i pd:%i fps:%5.2f", pixelSize, pixelsRedrawn, fps);
+    sprintf(suffix, "size:%i pd:%i/%lu/s fps:%5.2f cyc:%lu/s ovr:%lu",
+            pixelSize, pixelsRedrawn, redrawRate, fps, cycleRate,
+            animation.stepOverruns());
 
     // Copy the contents of the first array into the combined array
     strcpy(msg, prefix);
@@ -573,26 +1413,36 @@ int main() {
 
     if (pixelSize != oldPixelSize || golFadeSteps != oldFadeSteps ||
         golStartPattern != oldGolStartPattern) {
-      // Need to destroy and recreate animation objects
-      animation.~Animation();
-      animationMode = animModeGol;
+      // A new pixel size on its own carries on with the same animation,
+      // rescaled. New Game of Life settings switch to the Game of Life.
+      if (golFadeSteps != oldFadeSteps ||
+          golStartPattern != oldGolStartPattern) {
+        animationMode = animModeGol;
+      }
       if (golStartPattern > 0 && golStartPattern != 3) {
         if (pixelSize > 8) pixelSize = 8;
         if (pixelSize < 2) pixelSize = 2;
-        new (&animation) Animation(pixelSize, steps, minSteps, golFadeSteps,
-                                   golDelay, golStartPattern, shake, bounce);
-      } else if (pixelSize > 1) {
-        new (&animation) Animation(pixelSize, steps, minSteps, golFadeSteps,
-                                   golDelay, golStartPattern, shake, bounce);
-      } else {
-        new (&animation) Animation(1, steps, minSteps, golFadeSteps, golDelay,
-                                   golStartPattern, shake, bounce);
       }
-      // Reset residual value as animation class was recreated
-      if (residual) {
-        animation.residual = 50;
+      if (pixelSize == oldPixelSize) {
+        // Same grid, so just restart the Game of Life with the new settings
+        animation.reconfigure(golFadeSteps, golDelay, golStartPattern);
       } else {
-        animation.residual = 0;
+        // The grid size is fixed when the renderer is created, so a new pixel
+        // size needs the animation objects to be recreated. The cell buffers
+        // are shared, so only the renderer and animations are reallocated,
+        // and the image is carried over at the new scale.
+        animation.keepImage();
+        animation.~Animation();
+        new (&animation)
+            Animation(pixelSize > 1 ? pixelSize : 1, steps, minSteps,
+                      golFadeSteps, golDelay, golStartPattern, shake, bounce);
+        // Reset residual value as animation class was recreated
+        if (residual) {
+          animation.residual = 50;
+        } else {
+          animation.residual = 0;
+        }
+        animation.restoreImage(animationMode);
       }
     }
   }
@@ -11,12 +11,14 @@
 #include <math.h>
 #include <string.h>
 
+#include <algorithm>
 #include <cstdlib>
 #include <vector>
 
 #include "../drivers/lsm6ds3/lsm6ds3.hpp"
 #include "../drivers/touchscreen/touchscreen.hpp"
 #include "../libraries/graphics/footleg_graphics.hpp"
+#include "../libraries/presenter/presenter.hpp"
 #include "drivers/st7701/st7701.hpp"
 #include "hardware/adc.h"
 #include "hardware/gpio.h"
@@ -35,7 +37,37 @@ using namespace pimoroni;
 #define FRAME_BUFFER_WIDTH 480
 #define FRAME_BUFFER_HEIGHT 240
 
+// The balls are drawn into a smaller buffer with square pixels, which is
+// upscaled into the frame buffer as it is presented. This uses a quarter of
+// the RAM of a full resolution buffer. Set these to match the frame buffer
+// size to draw at the full frame buffer resolution instead.
+#define DRAW_BUFFER_WIDTH 240
+#define DRAW_BUFFER_HEIGHT 240
+
+// Draw into an 8 bit palette buffer at the frame buffer resolution instead of
+// the RGB565 draw buffer. This fits into the memory of the draw buffer, and is
+// expanded to RGB565 through a lookup table from the palette as it is
+// presented. Balls are given colours from a fixed set so that each colour has
+// room in the palette for the shades its edges blend through.
+static const bool PALETTE_MODE = false;
+static const int PALETTE_BALL_COLOURS = 24;
+
 bool DRAW_AA = true;
+bool DRAW_SHADED = false;  // Draw balls as lit 3D spheres
+// Fraction of the draw buffer rows which can be dirty before the whole frame is
+// cleared and presented instead of just the dirty rows
+static const float DIRTY_FULL_FRAME_FRACTION = 0.5f;
+// Adjust the rendering quality to keep the time per loop of the simulation
+// near the target as the number of balls changes. Quality steps down a level
+// after a run of slow frames, and back up after a longer run with plenty of
+// headroom, so it does not flip back and forth between two levels.
+bool AUTO_QUALITY = true;
+static const float TARGET_FRAME_US = 25000;     // 40 simulation steps a second
+static const float QUALITY_DOWN_FRACTION = 1.1f;  // Of the target frame time
+static const float QUALITY_UP_FRACTION = 0.6f;
+static const int QUALITY_DOWN_FRAMES = 15;
+static const int QUALITY_UP_FRAMES = 90;
+static const float SMALL_BALL_RADIUS = 8;  // Not AA'd at reduced quality
 static const int MAX_BALLS = 255;  // Limit of the vector? Crashes above 256
                                    // possibly to due running out of RAM?
 
@@ -68,16 +100,37 @@ static const uint TOUCH_HELD_TIME = 1000;
 static const uint TOUCH_CORNER_SIZE = 60;
 
 uint16_t back_buffer[FRAME_BUFFER_WIDTH * FRAME_BUFFER_HEIGHT];
-uint16_t front_buffer[FRAME_BUFFER_WIDTH * FRAME_BUFFER_HEIGHT];
+uint16_t front_buffer[DRAW_BUFFER_WIDTH * DRAW_BUFFER_HEIGHT];
+static_assert(FRAME_BUFFER_WIDTH * FRAME_BUFFER_HEIGHT <= sizeof(front_buffer),
+              "Palette buffer does not fit into the draw buffer memory");
 
 ST7701* presto;
-PicoGraphics_PenRGB565* display;
+// A draw buffer resolution in the draw buffer memory, with the graphics
+// objects which draw into it. Only one of rgb and palette is set.
+struct DrawTarget {
+  PicoGraphics* display;
+  PicoGraphics_PenRGB565* rgb = nullptr;
+  PicoGraphics_PenP8* palette = nullptr;
+  FootlegGraphics* graphics;
+};
+DrawTarget fullRes;  // The draw buffer resolution
+DrawTarget lowRes;   // Used when frames take too long at full resolution
+DrawTarget* target;  // The one being drawn on, as display and footlegGraphics
+PicoGraphics* display;
 FootlegGraphics* footlegGraphics;
+Presenter* presenter;
 LSM6DS3* accel;
 
 const uint8_t MODE_BOUNCE = 0;
 const uint8_t MODE_FORCES = 1;
 
+// Rendering quality levels, each adding to the savings of the one before
+const uint8_t QUALITY_FULL = 0;
+const uint8_t QUALITY_SMALL_NO_AA = 1;  // Small balls drawn without AA
+const uint8_t QUALITY_HALF_RATE = 2;    // Render every other frame
+const uint8_t QUALITY_LOW_RES = 3;      // Draw into the lower resolution buffer
+const uint8_t QUALITY_LOWEST = QUALITY_LOW_RES;
+
 uint32_t time() {
   absolute_time_t t = get_absolute_time();
   return to_ms_since_boot(t);
@@ -97,6 +150,20 @@ struct idxPair {
   uint16_t idx2;
 };
 
+std::vector<uint16_t> ballPens;  // Fixed set of ball colours in palette mode
+
+// Generate random colour which is not too dark
+void randomColour(uint8_t& r, uint8_t& g, uint8_t& b) {
+  r = 0;
+  g = 0;
+  b = 0;
+  while (r + g + b < 224) {
+    r = rand() % 255;
+    g = rand() % 255;
+    b = rand() % 255;
+  }
+}
+
 pt createShape(int x = -999, int y = -999, int minX = 0, int minY = 0,
                int maxX = screen_width, int maxY = screen_height) {
   pt shape;
@@ -111,19 +178,143 @@ pt createShape(int x = -999, int y = -999, int minX = 0, int minY = 0,
   shape.r = (rand() % (MAXBALLSIZE - 2)) + 2;
   shape.dx = 4.0 - (float(rand() % 255) / 32.0);
   shape.dy = 4.0 - (float(rand() % 255) / 32.0);
-  // Generate random colour which is not too dark
-  uint8_t r = 0;
-  uint8_t g = 0;
-  uint8_t b = 0;
-  while (r + g + b < 224) {
-    r = rand() % 255;
-    g = rand() % 255;
-    b = rand() % 255;
+  if (PALETTE_MODE) {
+    shape.pen = ballPens[rand() % ballPens.size()];
+  } else {
+    uint8_t r, g, b;
+    randomColour(r, g, b);
+    shape.pen = display->create_pen(r, g, b);
   }
-  shape.pen = display->create_pen(r, g, b);
   return shape;
 };
 
+// Area of the draw buffer a ball at screen position x,y with radius r can
+// touch, including the anti-aliased edge pixels
+Rect ballBounds(float x, float y, float r) {
+  float scaleX = float(display->bounds.w) / screen_width;
+  float scaleY = float(display->bounds.h) / screen_height;
+  int x1 = int(floorf((x - r) * scaleX)) - 1;
+  int y1 = int(floorf((y - r) * scaleY)) - 1;
+  int x2 = int(ceilf((x + r) * scaleX)) + 2;
+  int y2 = int(ceilf((y + r) * scaleY)) + 2;
+  return Rect(x1, y1, x2 - x1, y2 - y1).intersection(display->bounds);
+}
+
+// Mark the rows covered by a rectangle as needing to be presented
+void markDirtyRows(const Rect& rect, bool* dirtyRows) {
+  for (int y = rect.y; y < rect.y + rect.h; y++) {
+    dirtyRows[y] = true;
+  }
+}
+
+// Build the list of runs of dirty rows
+void findRowRanges(const bool* dirtyRows, int height,
+                   std::vector<RowRange>& ranges) {
+  ranges.clear();
+  int y = 0;
+  while (y < height) {
+    if (dirtyRows[y]) {
+      uint16_t firstRow = y;
+      while (y < height && dirtyRows[y]) y++;
+      ranges.push_back({firstRow, uint16_t(y)});
+    } else {
+      y++;
+    }
+  }
+}
+
+// Number of rows in a list of row ranges. Whole rows are cleared and
+// presented, so this is what decides whether to do the whole frame instead.
+int countRows(const std::vector<RowRange>& ranges) {
+  int rows = 0;
+  for (auto& range : ranges) rows += range.last - range.first;
+  return rows;
+}
+
+DrawTarget createTarget(int width, int height) {
+  DrawTarget t;
+  if (PALETTE_MODE) {
+    t.palette = new PicoGraphics_PenP8(width, height, front_buffer);
+    t.graphics = new FootlegGraphics(t.palette, (uint8_t*)front_buffer);
+    t.display = t.palette;
+  } else {
+    t.rgb = new PicoGraphics_PenRGB565(width, height, front_buffer);
+    t.graphics = new FootlegGraphics(t.rgb, front_buffer);
+    t.display = t.rgb;
+  }
+  return t;
+}
+
+void useTarget(DrawTarget* t) {
+  target = t;
+  display = t->display;
+  footlegGraphics = t->graphics;
+}
+
+// Present or clear rows of the draw buffer in whichever format it uses
+void presentFrame(const RowRange* ranges, size_t count) {
+  if (PALETTE_MODE) {
+    presenter->presentAsync(target->palette, ranges, count);
+  } else {
+    presenter->presentAsync(target->rgb, ranges, count);
+  }
+}
+
+void clearFrame(uint16_t pen, const RowRange* ranges, size_t count) {
+  if (PALETTE_MODE) {
+    presenter->clearAsync(target->palette, pen, ranges, count);
+  } else {
+    presenter->clearAsync(target->rgb, pen, ranges, count);
+  }
+}
+
+// Tracks the average time per loop and picks the rendering quality level.
+// Loops which render a frame and loops which skip rendering are timed
+// separately, so that stepping up from a level which skips frames is judged
+// on what the loops will cost once they render more often.
+struct QualityGovernor {
+  uint8_t level = QUALITY_FULL;
+  float avgRenderUs = 0;  // Loops which rendered a frame
+  float avgSkipUs = 0;    // Loops which skipped rendering
+  int slowFrames = 0;  // Consecutive frames over the step down threshold
+  int fastFrames = 0;  // Consecutive frames under the step up threshold
+
+  // Average loop time when rendering one loop in every skip + 1
+  float loopUs(uint8_t skip) {
+    return (avgRenderUs + skip * avgSkipUs) / (skip + 1);
+  }
+
+  // Returns true when the quality level changes. The skip is the number of
+  // loops skipped between frames set by the user.
+  bool update(uint32_t frameUs, bool rendered, uint8_t renderSkip) {
+    // Start the averages again after a change, as the old ones are stale
+    float& avgUs = rendered ? avgRenderUs : avgSkipUs;
+    avgUs = avgUs == 0 ? frameUs : avgUs * 0.9f + frameUs * 0.1f;
+    if (avgRenderUs == 0) return false;
+
+    uint8_t skip = renderSkip + (level >= QUALITY_HALF_RATE ? 1 : 0);
+    uint8_t skipUp = renderSkip + (level > QUALITY_HALF_RATE ? 1 : 0);
+    slowFrames = loopUs(skip) > TARGET_FRAME_US * QUALITY_DOWN_FRACTION
+                     ? slowFrames + 1
+                     : 0;
+    fastFrames = loopUs(skipUp) < TARGET_FRAME_US * QUALITY_UP_FRACTION
+                     ? fastFrames + 1
+                     : 0;
+    if (slowFrames >= QUALITY_DOWN_FRAMES && level < QUALITY_LOWEST) {
+      level++;
+    } else if (fastFrames >= QUALITY_UP_FRAMES && level > QUALITY_FULL) {
+      level--;
+    } else {
+      return false;
+    }
+    avgRenderUs = 0;
+    avgSkipUs = 0;
+    slowFrames = 0;
+    fastFrames = 0;
+    return true;
+  }
+};
+
 // float debug1, debug2, debug3 = 0.0;
 
 struct Vector3 {
@@ -171,9 +362,18 @@ int main() {
       FRAME_BUFFER_WIDTH, FRAME_BUFFER_HEIGHT, ROTATE_0,
       SPIPins{spi1, LCD_CS, LCD_CLK, LCD_DAT, PIN_UNUSED, LCD_DC, BACKLIGHT},
       back_buffer);
-  display = new PicoGraphics_PenRGB565(FRAME_BUFFER_WIDTH, FRAME_BUFFER_HEIGHT,
-                                       front_buffer);
-  footlegGraphics = new FootlegGraphics(display, front_buffer);
+  if (PALETTE_MODE) {
+    fullRes = createTarget(FRAME_BUFFER_WIDTH, FRAME_BUFFER_HEIGHT);
+  } else {
+    fullRes = createTarget(DRAW_BUFFER_WIDTH, DRAW_BUFFER_HEIGHT);
+  }
+  // Half the resolution, in the same memory, so it is still upscaled to the
+  // screen by a whole number of pixels
+  lowRes = createTarget(fullRes.display->bounds.w / 2,
+                        fullRes.display->bounds.h / 2);
+  useTarget(&fullRes);
+  presenter =
+      new Presenter(back_buffer, FRAME_BUFFER_WIDTH, FRAME_BUFFER_HEIGHT);
   presto->init();
 
   static I2C i2c(30, 31, 100000);
@@ -186,8 +386,21 @@ int main() {
   Point text_location(5, 5);
   Point lastTouch(0, 0);
 
-  Pen BG = display->create_pen(0, 0, 0);
+  // Palette entry 0 is reserved for the black background
+  Pen BG = PALETTE_MODE ? 0 : display->create_pen(0, 0, 0);
   Pen WHITE = display->create_pen(255, 255, 255);
+  if (PALETTE_MODE) {
+    // Both resolutions are given the same pens in the same order, so they
+    // share one palette
+    lowRes.display->create_pen(255, 255, 255);
+    for (int i = 0; i < PALETTE_BALL_COLOURS; i++) {
+      uint8_t r, g, b;
+      randomColour(r, g, b);
+      ballPens.push_back(fullRes.graphics->createPen(r, g, b));
+      lowRes.graphics->createPen(r, g, b);
+    }
+    presenter->setPalette(fullRes.palette);
+  }
 
   // Get the start time (used to calculate fps)
   start_fps = time_us_64();
@@ -196,6 +409,19 @@ int main() {
   std::vector<pt> shapes;          // These are the balls in the simulation
   std::vector<idxPair> mergeList;  // List of pairs of balls indices to be
                                    // merged into one after collisions
+  std::vector<CircleInstance> circles;  // Balls to draw in the next frame
+
+  // Areas of the draw buffer drawn on in the last frame. Everything outside
+  // these is background, so only these need clearing for the next frame.
+  std::vector<Rect> prevDirty;
+  std::vector<Rect> dirty;
+  static bool dirtyRows[FRAME_BUFFER_HEIGHT > DRAW_BUFFER_HEIGHT
+                            ? FRAME_BUFFER_HEIGHT
+                            : DRAW_BUFFER_HEIGHT];
+  std::vector<RowRange> dmaRanges;
+  bool fullFrame = true;  // Present the whole of the next frame
+  RowRange allRows = {0, uint16_t(display->bounds.h)};
+  clearFrame(BG, &allRows, 1);
 
   // Create 2 balls initially
   for (int i = 0; i < 1; i++) {  // DEBUG: Creating 25
@@ -209,6 +435,8 @@ int main() {
   float maxY = screen_height;
   uint8_t renderSkip = 0;
   uint8_t renderCount = 0;
+  QualityGovernor governor;
+  uint64_t lastLoopTime = time_us_64();
 
   uint8_t mode = MODE_BOUNCE;
   bool showText = true;
@@ -273,9 +501,18 @@ int main() {
               // Top Left Corner, toggle text visibility
               showText = !showText;
               actionTaken = true;
-              if (showText)
-                DRAW_AA =
-                    !DRAW_AA;  // Toggle AA off on alternate showing of text
+              if (showText) {
+                // Cycle through AA, flat and shaded balls on alternate
+                // showing of text
+                if (DRAW_SHADED) {
+                  DRAW_SHADED = false;
+                  DRAW_AA = true;
+                } else if (DRAW_AA) {
+                  DRAW_AA = false;
+                } else {
+                  DRAW_SHADED = true;
+                }
+              }
             } else if (touchPoint.y > touch.bounds.h - TOUCH_CORNER_SIZE) {
               // Bottom Left Corner
               if (mode == MODE_BOUNCE) {
@@ -574,13 +811,20 @@ int main() {
     }  // End merges block
 
     if (renderCount == 0) {
-      // Update screen
-      display->set_pen(BG);
-      display->clear();
-
+      // Update screen. The areas drawn on in the last frame were cleared in
+      // the background after it was presented, so wait for that to finish
+      // before drawing. Those rows need presenting again along with the rows
+      // drawn on in this frame.
+      presenter->waitForDma();
+      memset(dirtyRows, 0, sizeof(dirtyRows));
+      for (auto& rect : prevDirty) markDirtyRows(rect, dirtyRows);
+      int fullFrameRows = DIRTY_FULL_FRAME_FRACTION * display->bounds.h;
+
+      dirty.clear();
+      circles.clear();
       for (auto& shape : shapes) {
         // Skip the slow calcs if 1:1 scale with screen
-        int x, y, r;
+        float x, y, r;
         if (minX == 0 && minY == 0) {
           // Draw circles at 1:1 scale on screen
           x = shape.x;
@@ -593,12 +837,25 @@ int main() {
           r = screen_height * shape.r / (maxY - minY);
           if (r < 2) r = 2;
         }
-        if (DRAW_AA) {
+        Rect bounds = ballBounds(x, y, r);
+        if (bounds.empty()) continue;  // Ball is outside the visible area
+        dirty.push_back(bounds);
+        markDirtyRows(bounds, dirtyRows);
+        bool smallNoAA =
+            governor.level >= QUALITY_SMALL_NO_AA && r < SMALL_BALL_RADIUS;
+        if (DRAW_AA && !DRAW_SHADED && !smallNoAA) {
+          // Draw at the sub-pixel position so slow balls move smoothly
           footlegGraphics->drawCircleAA(x, y, r, shape.pen);
         } else {
-          footlegGraphics->drawCircle(x, y, r, shape.pen);
+          circles.push_back(
+              {int16_t(x), int16_t(y), uint16_t(r), shape.pen});
         }
       }
+      if (DRAW_SHADED) {
+        footlegGraphics->drawSpheres(circles.data(), circles.size());
+      } else {
+        footlegGraphics->drawCircles(circles.data(), circles.size(), false);
+      }
 
       // Calculate fps
       frame_counter++;
@@ -658,9 +915,14 @@ int main() {
           if (mass || mergesOn || gravity) {
             strcat(msg, ")");
           }
-          if (DRAW_AA) {
+          if (DRAW_SHADED) {
+            strcat(msg, " 3D");
+          } else if (DRAW_AA) {
             strcat(msg, " AA");
           }
+          if (AUTO_QUALITY && governor.level > QUALITY_FULL) {
+            sprintf(msg + strlen(msg), " Q-%i", governor.level);
+          }
 
           // Concatenate the contents of the second array into the combined
           // array
@@ -668,18 +930,70 @@ int main() {
         }
 
         // Render Mode info and FPS to screen
+        int textScale = std::max(display->bounds.w * 2 / screen_width, 1);
         display->set_pen(WHITE);
         display->text(msg, text_location, display->bounds.w - text_location.x,
-                      2);
+                      textScale);
+        // Track the text as dirty, allowing for it wrapping onto a 2nd line
+        Rect textBounds = Rect(0, 0, display->bounds.w,
+                               text_location.y + 2 * 10 * textScale)
+                              .intersection(display->bounds);
+        dirty.push_back(textBounds);
+        markDirtyRows(textBounds, dirtyRows);
       }
 
-      presto->update(display);
+      // Present the frame. At full resolution this is copied by DMA while the
+      // physics for the next frame is calculated.
+      findRowRanges(dirtyRows, display->bounds.h, dmaRanges);
+      if (fullFrame || countRows(dmaRanges) > fullFrameRows) {
+        presentFrame(&allRows, 1);
+      } else {
+        // Only present runs of rows which have changed
+        presentFrame(dmaRanges.data(), dmaRanges.size());
+      }
+
+      // Start clearing what was drawn in this frame, which runs in the
+      // background (after the present) ready for the next frame. When much of
+      // the frame was drawn on, clearing the whole frame is faster than
+      // working through the dirty areas.
+      memset(dirtyRows, 0, sizeof(dirtyRows));
+      for (auto& rect : dirty) markDirtyRows(rect, dirtyRows);
+      findRowRanges(dirtyRows, display->bounds.h, dmaRanges);
+      fullFrame = countRows(dmaRanges) > fullFrameRows;
+      if (fullFrame) {
+        clearFrame(BG, &allRows, 1);
+      } else {
+        clearFrame(BG, dmaRanges.data(), dmaRanges.size());
+      }
+      prevDirty.swap(dirty);
+    }
+
+    if (AUTO_QUALITY) {
+      uint64_t now = time_us_64();
+      // A frame was rendered this loop if the render counter is at zero
+      if (governor.update(now - lastLoopTime, renderCount == 0, renderSkip)) {
+        DrawTarget* newTarget =
+            governor.level >= QUALITY_LOW_RES ? &lowRes : &fullRes;
+        if (newTarget != target) {
+          // The dirty areas are for the old resolution, so clear and present
+          // the whole of the next frame instead
+          presenter->waitForDma();
+          useTarget(newTarget);
+          allRows.last = display->bounds.h;
+          clearFrame(BG, &allRows, 1);
+          prevDirty.clear();
+          fullFrame = true;
+        }
+      }
+      lastLoopTime = now;
     }
 
     // Increment render counter (graphics are only rendered on loop cycles where
     // this rolls over to zero)
     renderCount++;
-    if (renderCount > renderSkip) renderCount = 0;
+    uint8_t skip = renderSkip;
+    if (AUTO_QUALITY && governor.level >= QUALITY_HALF_RATE) skip++;
+    if (renderCount > skip) renderCount = 0;
   }
 
   return 0;
@@ -0,0 +1,131 @@
+/*
+ * A full resolution graphics demo for the Pimoroni Presto. There is not
+ * enough RAM for a 480 x 480 double buffer, so each frame is recorded as a
+ * display list and rendered in bands of rows by the band renderer library.
+ * Each finished band is copied into the 480 x 480 scan-out buffer just behind
+ * the display reading it, so the screen shows whole frames drawn at full
+ * resolution without needing PSRAM, as long as each frame is drawn within
+ * one refresh of the display.
+ *
+ * Copyright (c) 2025 Dr Footleg
+ *
+ * License: GNU GPL v3.0
+ */
+#include <math.h>
+#include <stdio.h>
+
+#include "../libraries/band_renderer/band_renderer.hpp"
+#include "../libraries/graphics/footleg_graphics.hpp"
+#include "drivers/st7701/st7701.hpp"
+#include "libraries/pico_graphics/pico_graphics.hpp"
+#include "pico/stdlib.h"
+#include "pico/time.h"
+
+using namespace pimoroni;
+
+#define FRAME_BUFFER_WIDTH 480
+#define FRAME_BUFFER_HEIGHT 480
+
+// Rows in each of the two bands the frame is drawn in
+#define BAND_HEIGHT 16
+
+static const uint16_t screen_width = 480;
+static const uint16_t screen_height = 480;
+
+static const uint BACKLIGHT = 45;
+static const uint LCD_CLK = 26;
+static const uint LCD_CS = 28;
+static const uint LCD_DAT = 27;
+static const uint LCD_DC = -1;
+static const uint LCD_D0 = 1;
+
+uint16_t screen_buffer[FRAME_BUFFER_WIDTH * FRAME_BUFFER_HEIGHT];
+uint16_t band_buffer[FRAME_BUFFER_WIDTH * BAND_HEIGHT * 2];
+
+ST7701* presto;
+PicoGraphics_PenRGB565* display;
+FootlegGraphics* footlegGraphics;
+BandRenderer* bands;
+
+int main() {
+  set_sys_clock_khz(240000, true);
+  stdio_init_all();
+
+  gpio_init(LCD_CS);
+  gpio_put(LCD_CS, 1);
+  gpio_set_dir(LCD_CS, 1);
+
+  presto = new ST7701(
+      FRAME_BUFFER_WIDTH, FRAME_BUFFER_HEIGHT, ROTATE_0,
+      SPIPins{spi1, LCD_CS, LCD_CLK, LCD_DAT, PIN_UNUSED, LCD_DC, BACKLIGHT},
+      screen_buffer);
+  // The display covers the whole screen, but only has memory for the bands.
+  // The band renderer points it at each band as it is drawn.
+  display = new PicoGraphics_PenRGB565(FRAME_BUFFER_WIDTH, FRAME_BUFFER_HEIGHT,
+                                       band_buffer);
+  footlegGraphics = new FootlegGraphics(display, band_buffer);
+  bands = new BandRenderer(display, footlegGraphics, screen_buffer,
+                           band_buffer, BAND_HEIGHT);
+  presto->init();
+
+  Pen BG = display->create_pen(0, 0, 0);
+  Pen WHITE = display->create_pen(255, 255, 255);
+  Pen RED = display->create_pen(255, 0, 0);
+  Pen ORANGE = display->create_pen(255, 128, 0);
+  Pen YELLOW = display->create_pen(255, 255, 0);
+  Pen GREEN = display->create_pen(0, 255, 0);
+  Pen BLUE = display->create_pen(0, 0, 255);
+  Pen PINK = display->create_pen(192, 0, 128);
+  Pen PURPLE = display->create_pen(128, 0, 128);
+  Pen colours[] = {RED, ORANGE, YELLOW, GREEN, BLUE, PURPLE};
+
+  char msg[64];
+  float ballX = 100.0f, ballY = 300.0f;
+  float ballDX = 2.3f, ballDY = 1.7f;
+  float angle = 0.0f;
+  uint16_t frame_counter = 0;
+  uint64_t start_fps = time_us_64();
+  float fps = 0.0f;
+
+  while (true) {
+    bands->begin(BG);
+
+    // Rows of circles, flat and anti-aliased
+    for (int i = 0; i < 9; i++) {
+      bands->circle(30 + i * 50, 30, i + 1, colours[i % 6]);
+      bands->circleAA(30 + i * 50, 60, i + 1, colours[i % 6]);
+      bands->circle(30 + i * 50, 100, i + 10, colours[i % 6]);
+      bands->circleAA(30 + i * 50, 140, i + 10, colours[i % 6]);
+    }
+
+    bands->rectangle({20, 190, display->bounds.w - 40, 60}, PINK);
+    bands->text("Hello Presto World!", {30, 210},
+                display->bounds.w - 30, 2, YELLOW);
+
+    // A spinning line and a ball bouncing round the lower part of the screen
+    float cx = 240.0f, cy = 370.0f;
+    bands->lineAA(cx - 100 * cosf(angle), cy - 100 * sinf(angle),
+                  cx + 100 * cosf(angle), cy + 100 * sinf(angle), WHITE);
+    bands->sphere(ballX, ballY, 30, GREEN);
+    angle += 0.02f;
+    ballX += ballDX;
+    ballY += ballDY;
+    if (ballX < 30 || ballX > screen_width - 30) ballDX = -ballDX;
+    if (ballY < 270 || ballY > screen_height - 30) ballDY = -ballDY;
+
+    sprintf(msg, "%ix%i in %i row bands fps:%.1f", FRAME_BUFFER_WIDTH,
+            FRAME_BUFFER_HEIGHT, BAND_HEIGHT, fps);
+    bands->text(msg, {5, 460}, display->bounds.w - 5, 2, WHITE);
+
+    bands->render();
+
+    // Calculate fps over each second
+    frame_counter++;
+    uint64_t elapsed = time_us_64() - start_fps;
+    if (elapsed > 1000000) {
+      fps = frame_counter * 1000000.0f / elapsed;
+      frame_counter = 0;
+      start_fps += elapsed;
+    }
+  }
+}
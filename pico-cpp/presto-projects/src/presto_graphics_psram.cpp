@@ -25,6 +25,7 @@
 
 #include "../drivers/touchscreen/touchscreen.hpp"
 #include "../libraries/graphics/footleg_graphics.hpp"
+#include "../libraries/presenter/presenter.hpp"
 #include "drivers/st7701/st7701.hpp"
 #include "hardware/adc.h"
 #include "hardware/gpio.h"
@@ -50,6 +51,12 @@ using namespace pimoroni;
 #define DRAW_BUF_SIZE \
   (FRAME_BUFFER_WIDTH * FRAME_BUFFER_HEIGHT * sizeof(uint16_t) / 1)
 
+// Rows of the drawing buffer cached in chip RAM. Drawing is collected in these
+// and written to psram in bursts, which is much faster than writing scattered
+// pixels to psram.
+#define LINE_CACHE_ROWS 32
+bool USE_LINE_CACHE = true;
+
 bool DRAW_AA = true;  // Sets whether to antialias the edges of the circles
 
 // This is the resolution of the simulation space (independent of the resolution
@@ -67,10 +74,13 @@ static const uint LCD_D0 = 1;
 // uint16_t draw_buffer[FRAME_BUFFER_WIDTH * FRAME_BUFFER_HEIGHT];
 uint16_t* draw_buffer;
 uint16_t screen_buffer[FRAME_BUFFER_WIDTH * FRAME_BUFFER_HEIGHT];
+uint16_t line_cache_buffer[FRAME_BUFFER_WIDTH * LINE_CACHE_ROWS];
 
 ST7701* presto;
-PicoGraphics_PenRGB565* display;
+CachedPenRGB565* display;
 FootlegGraphics* footlegGraphics;
+LineCache* lineCache;
+Presenter* presenter;
 
 // Maximum time in ms for a touch and release to be acted on as a 'short press'
 static const uint TOUCH_SHORT_PRESS_TIME = 200;
@@ -119,10 +129,17 @@ int main() {
       FRAME_BUFFER_WIDTH, FRAME_BUFFER_HEIGHT, ROTATE_0,
       SPIPins{spi1, LCD_CS, LCD_CLK, LCD_DAT, PIN_UNUSED, LCD_DC, BACKLIGHT},
       screen_buffer);
-  display = new PicoGraphics_PenRGB565(FRAME_BUFFER_WIDTH, FRAME_BUFFER_HEIGHT,
-                                       draw_buffer);
+  display = new CachedPenRGB565(FRAME_BUFFER_WIDTH, FRAME_BUFFER_HEIGHT,
+                                draw_buffer);
 
   footlegGraphics = new FootlegGraphics(display, draw_buffer);
+  lineCache = new LineCache(draw_buffer, FRAME_BUFFER_WIDTH,
+                            FRAME_BUFFER_HEIGHT, line_cache_buffer,
+                            LINE_CACHE_ROWS);
+  display->setCache(lineCache);
+  footlegGraphics->setLineCache(lineCache);
+  presenter =
+      new Presenter(screen_buffer, FRAME_BUFFER_WIDTH, FRAME_BUFFER_HEIGHT);
 
   presto->init();
 
@@ -146,6 +163,7 @@ int main() {
   bool showText = true;
   bool showGrid = true;
 
+  presenter->clearAsync(display, BG);
   // Main simulation loop
   while (true) {
     // Check whether the touch screen is being touched right now
@@ -195,7 +213,13 @@ int main() {
           } else if (touchPoint.x > touch.bounds.w - TOUCH_CORNER_SIZE) {
             // Right side of screen
             if (touchPoint.y < TOUCH_CORNER_SIZE) {
-              // Top Right Corner
+              // Top Right Corner, toggle the line cache to compare fps
+              USE_LINE_CACHE = !USE_LINE_CACHE;
+              display->setCache(USE_LINE_CACHE ? lineCache : nullptr);
+              footlegGraphics->setLineCache(USE_LINE_CACHE ? lineCache
+                                                           : nullptr);
+              actionTaken = true;
+              lastSettingsChange = time_us_64();
             } else if (touchPoint.y > touch.bounds.h - TOUCH_CORNER_SIZE) {
               // Bottom Right Corner
               showGrid = !showGrid;
@@ -219,14 +243,14 @@ int main() {
       }
     }
 
-    // Update screen
-    display->set_pen(BG);
-    display->clear();
+    // Update screen once the buffer has been cleared by DMA
+    presenter->waitForDma();
 
     if (showGrid) {
       display->set_pen(GREY);
-      for (int x = 8; x < screen_width; x += 8) {
-        for (int y = 8; y < screen_height; y += 8) {
+      // Draw a row at a time, so each row is only fetched once by the cache
+      for (int y = 8; y < screen_height; y += 8) {
+        for (int x = 8; x < screen_width; x += 8) {
           display->set_pixel(Point(x, y));
         }
       }
@@ -290,7 +314,7 @@ int main() {
               FRAME_BUFFER_HEIGHT, lastTouch.x, lastTouch.y);
     }
 
-    sprintf(suffix, " fps:%5.2f", fps);
+    sprintf(suffix, "%s fps:%5.2f", USE_LINE_CACHE ? " LC" : "", fps);
 
     // Copy the contents of the first array into the combined array
     strcpy(msg, prefix);
@@ -307,7 +331,11 @@ int main() {
       display->set_pixel(Point(4, 4));
     }
 
+    // Drawing in the line cache must be in psram before it is copied
+    if (USE_LINE_CACHE) lineCache->flush();
     presto->update(display);
+    // Clear the buffer by DMA in the background while checking for touches
+    presenter->clearAsync(display, BG);
   }
 
   return 0;
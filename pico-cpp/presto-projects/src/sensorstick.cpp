@@ -15,6 +15,8 @@
  */
 
 #include "../drivers/lsm6ds3/lsm6ds3.hpp"
+#include "../libraries/frame_pacer/frame_pacer.hpp"
+#include "../libraries/presenter/presenter.hpp"
 #include "drivers/st7701/st7701.hpp"
 #include "libraries/pico_graphics/pico_graphics.hpp"
 #include "pico/multicore.h"
@@ -46,6 +48,7 @@ uint16_t draw_buffer[FRAME_BUFFER_WIDTH * FRAME_BUFFER_HEIGHT];
 
 ST7701* presto;
 PicoGraphics_PenRGB565* display;
+Presenter* presenter;
 LSM6DS3* accel;
 
 struct Vector3 {
@@ -94,6 +97,8 @@ int main() {
       screen_buffer);
   display = new PicoGraphics_PenRGB565(FRAME_BUFFER_WIDTH, FRAME_BUFFER_HEIGHT,
                                        draw_buffer);
+  presenter =
+      new Presenter(screen_buffer, FRAME_BUFFER_WIDTH, FRAME_BUFFER_HEIGHT);
 
   presto->init();
 
@@ -117,10 +122,9 @@ int main() {
   double angle = -56.0;            // -53.4
   static const int ACC1G = 17000;  // Accelerometer reading for 1G
 
+  FramePacer pacer(10000);  // 100 fps
+  presenter->clearAsync(display, BG);
   while (true) {
-    display->set_pen(BG);
-    display->clear();
-
     // Read IMU
     LSM6DS3::SensorData acceldata = accel->getReadings();
 
@@ -130,9 +134,11 @@ int main() {
                  (float)acceldata.az / ACC1G},
                 angle);
 
-    sprintf(msg, "ax: %.2f ay:%.2f az:%.2f a:%.2f", data.x, data.y, data.z,
-            angle);
+    sprintf(msg, "ax: %.2f ay:%.2f az:%.2f a:%.2f ovr:%lu", data.x, data.y,
+            data.z, angle, pacer.overruns());
 
+    // Wait for the buffer to be cleared by DMA before drawing into it
+    presenter->waitForDma();
     display->set_pen(PINK);
     display->rectangle({20, display->bounds.h / 2, display->bounds.w - 40,
                         display->bounds.h - 110});
@@ -147,6 +153,8 @@ int main() {
     }
 
     presto->update(display);
-    sleep_ms(10);
+    // Clear the buffer by DMA in the background while waiting
+    presenter->clearAsync(display, BG);
+    pacer.waitForFrame();
   }
 }
\ No newline at end of file